@@ -0,0 +1,42 @@
+#pragma once
+#ifndef ALIGNED_ALLOCATOR_H
+#define ALIGNED_ALLOCATOR_H
+
+#include <cstddef>
+#include <new>
+
+// Size of a cache line on the x86/ARM machines we target
+const size_t CACHE_LINE_SIZE = 64;
+
+// std::allocator replacement that places the first element on an
+// Alignment-byte boundary (C++17 aligned operator new)
+template <typename T, size_t Alignment = CACHE_LINE_SIZE>
+class AlignedAllocator {
+public:
+	typedef T value_type;
+
+	template <typename U>
+	struct rebind {
+		typedef AlignedAllocator<U, Alignment> other;
+	};
+
+	AlignedAllocator() noexcept {}
+	template <typename U>
+	AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+	T* allocate(size_t count) {
+		return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(Alignment)));
+	}
+
+	void deallocate(T* pointer, size_t) noexcept {
+		::operator delete(pointer, std::align_val_t(Alignment));
+	}
+};
+
+template <typename T, typename U, size_t Alignment>
+bool operator==(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&) { return true; }
+
+template <typename T, typename U, size_t Alignment>
+bool operator!=(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&) { return false; }
+
+#endif
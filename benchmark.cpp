@@ -7,8 +7,10 @@ int main() {
     std::string inputFile = "input.txt"; // File 1,000,000 numbers
     std::string outputFile = "output_benchmark.txt";
 
-    // 2. Ensure temp directory exists
+    // 2. Keep the runs in the temp directory
     FileIO::makeDirectory("temp");
+    SortOptions options;
+    options.tempDirs.push_back("temp");
 
     // 3. Define different chunk sizes to test (in Bytes)
     // Testing with 1MB, 2MB, and 5MB chunks
@@ -17,7 +19,7 @@ int main() {
     for (size_t size : tests) {
         std::cout << "\n>>> TESTING WITH CHUNK SIZE: " << (size / (1024 * 1024)) << " MB\n";
 
-        Sorter tester(inputFile, outputFile, size);
+        Sorter tester(inputFile, outputFile, size, options);
         tester.run();
 
         std::cout << "*******************************************\n";
@@ -0,0 +1,204 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <climits>
+#include <string>
+#include <queue>
+#include <functional>
+#include "heap.h"
+#include "loser_tree.h"
+#include "radix_sort.h"
+#include "sort_strategy.h"
+#include "utils.h"
+
+// Chunk-sized input drawn from the same distribution as generate_data
+std::vector<int> makeChunk(size_t count, int low, int high, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<> dis(low, high);
+    std::vector<int> values(count);
+    for (auto& v : values) v = dis(gen);
+    return values;
+}
+
+// Time one kernel over several repetitions, returning the best run in ms
+template <typename SortFn>
+double timeKernel(const std::vector<int>& input, SortFn sortFn, int repeats = 3) {
+    double best = 1e30;
+    for (int r = 0; r < repeats; r++) {
+        std::vector<int> data = input;
+        auto start = std::chrono::steady_clock::now();
+        sortFn(data);
+        auto stop = std::chrono::steady_clock::now();
+
+        if (!std::is_sorted(data.begin(), data.end())) {
+            std::cout << "  [Error] kernel produced unsorted output\n";
+        }
+        best = std::min(best, std::chrono::duration<double, std::milli>(stop - start).count());
+    }
+    return best;
+}
+
+void benchmarkChunkSorts(const std::string& label, int low, int high) {
+    std::cout << "\n>>> CHUNK SORT KERNELS: " << label << "\n";
+    std::cout << std::left << std::setw(10) << "Chunk"
+        << std::setw(10) << "Elements"
+        << std::setw(12) << "heap ms"
+        << std::setw(12) << "std::sort"
+        << std::setw(12) << "pdqsort"
+        << std::setw(12) << "radix"
+        << std::setw(12) << "sample(4t)"
+        << "radix vs heap\n";
+
+    // Chunk sizes used by benchmark.cpp: 1MB, 2MB, 5MB
+    size_t chunkBytes[] = { 1024 * 1024, 2 * 1024 * 1024, 5 * 1024 * 1024 };
+    std::vector<int> scratch;
+
+    for (size_t bytes : chunkBytes) {
+        size_t count = bytes / sizeof(int);
+        std::vector<int> input = makeChunk(count, low, high, 42);
+
+        double heapMs = timeKernel(input, [](std::vector<int>& v) { Heap::heapSort(v); });
+        double stdMs = timeKernel(input, [](std::vector<int>& v) { std::sort(v.begin(), v.end()); });
+        double pdqMs = timeKernel(input, [](std::vector<int>& v) { pdqSort(v.data(), v.data() + v.size()); });
+        double radixMs = timeKernel(input, [&](std::vector<int>& v) { RadixSort::sort(v, scratch); });
+        double sampleMs = timeKernel(input, [&](std::vector<int>& v) { parallelSampleSort(v, scratch, 4); });
+
+        std::cout << std::left << std::setw(10) << formatSize(bytes)
+            << std::setw(10) << count
+            << std::fixed << std::setprecision(2)
+            << std::setw(12) << heapMs
+            << std::setw(12) << stdMs
+            << std::setw(12) << pdqMs
+            << std::setw(12) << radixMs
+            << std::setw(12) << sampleMs
+            << std::setprecision(1) << (heapMs / radixMs) << "x\n";
+    }
+}
+
+// K sorted in-memory runs holding `total` elements between them
+std::vector<std::vector<int>> makeRuns(size_t k, size_t total, unsigned seed) {
+    std::vector<std::vector<int>> runs(k);
+    for (size_t i = 0; i < k; i++) {
+        runs[i] = makeChunk(total / k, INT_MIN, INT_MAX, seed + static_cast<unsigned>(i));
+        std::sort(runs[i].begin(), runs[i].end());
+    }
+    return runs;
+}
+
+struct HeapEntry {
+    int value;
+    int run;
+    bool operator<(const HeapEntry& other) const { return value < other.value; }
+    bool operator>(const HeapEntry& other) const { return value > other.value; }
+};
+
+// Merge engines over in-memory runs, so only the selection cost is timed
+void mergePriorityQueue(const std::vector<std::vector<int>>& runs, std::vector<int>& out) {
+    std::priority_queue<HeapEntry, std::vector<HeapEntry>, std::greater<HeapEntry>> pq;
+    std::vector<size_t> pos(runs.size(), 0);
+    for (size_t i = 0; i < runs.size(); i++) {
+        if (!runs[i].empty()) pq.push(HeapEntry{ runs[i][0], static_cast<int>(i) });
+    }
+    while (!pq.empty()) {
+        HeapEntry top = pq.top();
+        pq.pop();
+        out.push_back(top.value);
+        if (++pos[top.run] < runs[top.run].size()) {
+            pq.push(HeapEntry{ runs[top.run][pos[top.run]], top.run });
+        }
+    }
+}
+
+void mergeDaryHeap(const std::vector<std::vector<int>>& runs, std::vector<int>& out) {
+    DaryHeap<HeapEntry> heap;
+    std::vector<size_t> pos(runs.size(), 0);
+    for (size_t i = 0; i < runs.size(); i++) {
+        if (!runs[i].empty()) heap.insert(HeapEntry{ runs[i][0], static_cast<int>(i) });
+    }
+    while (!heap.isEmpty()) {
+        HeapEntry top = heap.peek();
+        out.push_back(top.value);
+        if (++pos[top.run] < runs[top.run].size()) {
+            top.value = runs[top.run][pos[top.run]];
+            heap.replaceTop(top);
+        }
+        else {
+            heap.pop();
+        }
+    }
+}
+
+void mergeLoserTree(const std::vector<std::vector<int>>& runs, std::vector<int>& out) {
+    LoserTree tree(runs.size());
+    std::vector<size_t> pos(runs.size(), 0);
+    for (size_t i = 0; i < runs.size(); i++) {
+        if (!runs[i].empty()) tree.setSource(static_cast<int>(i), runs[i][0]);
+    }
+    tree.build();
+    while (!tree.isEmpty()) {
+        int run = tree.winner();
+        out.push_back(tree.winnerKey());
+        if (++pos[run] < runs[run].size()) {
+            tree.replaceWinner(runs[run][pos[run]]);
+        }
+        else {
+            tree.exhaustWinner();
+        }
+    }
+}
+
+template <typename MergeFn>
+double timeMerge(const std::vector<std::vector<int>>& runs, size_t total, MergeFn mergeFn, int repeats = 3) {
+    double best = 1e30;
+    std::vector<int> out;
+    for (int r = 0; r < repeats; r++) {
+        out.clear();
+        out.reserve(total);
+        auto start = std::chrono::steady_clock::now();
+        mergeFn(runs, out);
+        auto stop = std::chrono::steady_clock::now();
+
+        if (out.size() != total || !std::is_sorted(out.begin(), out.end())) {
+            std::cout << "  [Error] merge produced wrong output\n";
+        }
+        best = std::min(best, std::chrono::duration<double, std::milli>(stop - start).count());
+    }
+    return best;
+}
+
+void benchmarkMerges() {
+    std::cout << "\n>>> K-WAY MERGE ENGINES: 4M elements, in-memory runs\n";
+    std::cout << std::left << std::setw(8) << "K"
+        << std::setw(16) << "priority_queue"
+        << std::setw(16) << "4-ary heap"
+        << std::setw(16) << "loser tree"
+        << "tree vs pq\n";
+
+    size_t kValues[] = { 4, 64, 1024 };
+    for (size_t k : kValues) {
+        size_t total = (4 * 1024 * 1024 / k) * k;
+        std::vector<std::vector<int>> runs = makeRuns(k, total, 7);
+
+        double pqMs = timeMerge(runs, total, mergePriorityQueue);
+        double heapMs = timeMerge(runs, total, mergeDaryHeap);
+        double treeMs = timeMerge(runs, total, mergeLoserTree);
+
+        std::cout << std::left << std::setw(8) << k
+            << std::fixed << std::setprecision(2)
+            << std::setw(16) << pqMs
+            << std::setw(16) << heapMs
+            << std::setw(16) << treeMs
+            << std::setprecision(1) << (pqMs / treeMs) << "x\n";
+    }
+}
+
+int main() {
+    benchmarkChunkSorts("uniform [-1,000,000, 1,000,000] (generate_data)", -1000000, 1000000);
+    benchmarkChunkSorts("uniform full int range", INT_MIN, INT_MAX);
+    benchmarkMerges();
+
+    std::cout << "\nBenchmark finished.\n";
+    return 0;
+}
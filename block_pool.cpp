@@ -0,0 +1,59 @@
+#include "block_pool.h"
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+
+//Alignment of the first block, for the disk and the page cache
+static const size_t BLOCK_ALIGNMENT = 4096;
+
+BlockPool::BlockPool(size_t blockBytes, size_t count, BufferPool* pool)
+	: buffers(nullptr), blockInts(0), blockCount(0) {
+	reset(blockBytes, count, pool);
+}
+
+BlockPool::~BlockPool() {
+	giveBuffer(buffers, storage);
+}
+
+void BlockPool::reset(size_t blockBytes, size_t count, BufferPool* pool) {
+	blockInts = std::max<size_t>(blockBytes / sizeof(int), 1);
+	blockCount = count;
+
+	//One allocation for every block; release the old one first
+	freeBlocks.clear();
+	giveBuffer(buffers, storage);
+	buffers = pool;
+	if (blockCount == 0) return;
+
+	size_t padInts = BLOCK_ALIGNMENT / sizeof(int);
+	storage = takeBuffer(buffers, blockInts * blockCount + padInts);
+	storage.resize(blockInts * blockCount + padInts);
+	uintptr_t address = reinterpret_cast<uintptr_t>(storage.data());
+	int* first = storage.data() + (BLOCK_ALIGNMENT - address % BLOCK_ALIGNMENT) % BLOCK_ALIGNMENT / sizeof(int);
+
+	for (size_t i = blockCount; i-- > 0;) {
+		freeBlocks.push_back(first + i * blockInts);
+	}
+}
+
+int* BlockPool::acquire() {
+	if (freeBlocks.empty()) {
+		throw std::runtime_error("Block pool exhausted");
+	}
+	int* block = freeBlocks.back();
+	freeBlocks.pop_back();
+	return block;
+}
+
+void BlockPool::release(int* block) {
+	freeBlocks.push_back(block);
+}
+
+size_t BlockPool::chooseBlockSize(size_t runs, size_t blocksPerRun, size_t budgetBytes) {
+	size_t blocks = std::max<size_t>(runs * blocksPerRun, 1);
+	size_t bytes = budgetBytes / blocks;
+
+	//Whole pages keep every block aligned for the disk and the page cache
+	bytes -= bytes % MIN_BLOCK_BYTES;
+	return std::min(std::max(bytes, MIN_BLOCK_BYTES), MAX_BLOCK_BYTES);
+}
@@ -0,0 +1,53 @@
+#pragma once
+#ifndef BLOCK_POOL_H
+#define BLOCK_POOL_H
+
+#include <cstddef>
+#include <vector>
+#include "buffer_pool.h"
+
+// Fixed-size int blocks carved out of one allocation, page-aligned.
+// The merge phase sizes the pool to its memory budget once and hands a
+// block to every run reader, instead of each reader allocating its own.
+// With a BufferPool the storage is taken from it and given back on the
+// next reset, so every merge pass reuses the same memory.
+class BlockPool {
+private:
+	std::vector<int> storage;       // Blocks start at the first page boundary
+	BufferPool* buffers;            // Not owned, may be null
+	std::vector<int*> freeBlocks;
+	size_t blockInts;
+	size_t blockCount;
+
+public:
+	// Smallest and largest block chooseBlockSize() will return
+	static constexpr size_t MIN_BLOCK_BYTES = 4 * 1024;
+	static constexpr size_t MAX_BLOCK_BYTES = 4 * 1024 * 1024;
+
+	BlockPool() : buffers(nullptr), blockInts(0), blockCount(0) {}
+	BlockPool(size_t blockBytes, size_t count, BufferPool* buffers = nullptr);
+	~BlockPool();
+
+	BlockPool(const BlockPool&) = delete;
+	BlockPool& operator=(const BlockPool&) = delete;
+
+	// Drop all blocks and allocate `count` blocks of blockBytes (rounded
+	// down to whole ints), from `buffers` when given. Blocks handed out
+	// earlier become invalid.
+	void reset(size_t blockBytes, size_t count, BufferPool* buffers = nullptr);
+
+	// Take a free block (throws when the pool is exhausted)
+	int* acquire();
+	void release(int* block);
+
+	size_t getBlockInts() const { return blockInts; }
+	size_t getBlockBytes() const { return blockInts * sizeof(int); }
+	size_t getBlockCount() const { return blockCount; }
+	size_t getFreeCount() const { return freeBlocks.size(); }
+
+	// Largest page-multiple block that gives `runs` readers `blocksPerRun`
+	// blocks each within budgetBytes, clamped to [MIN, MAX]_BLOCK_BYTES
+	static size_t chooseBlockSize(size_t runs, size_t blocksPerRun, size_t budgetBytes);
+};
+
+#endif
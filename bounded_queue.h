@@ -0,0 +1,55 @@
+#pragma once
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+// Blocking FIFO with a fixed capacity, used to hand work between threads.
+// push() blocks while full, pop() blocks while empty. After close(),
+// pop() drains the remaining items and then returns false.
+template <typename T>
+class BoundedQueue {
+private:
+	std::mutex mutex;
+	std::condition_variable notEmpty;
+	std::condition_variable notFull;
+	std::deque<T> items;
+	size_t capacity;
+	bool closed;
+
+public:
+	explicit BoundedQueue(size_t capacity)
+		: capacity(capacity > 0 ? capacity : 1), closed(false) {}
+
+	BoundedQueue(const BoundedQueue&) = delete;
+	BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+	void push(T item) {
+		std::unique_lock<std::mutex> lock(mutex);
+		notFull.wait(lock, [this] { return items.size() < capacity || closed; });
+		items.push_back(std::move(item));
+		notEmpty.notify_one();
+	}
+
+	bool pop(T& item) {
+		std::unique_lock<std::mutex> lock(mutex);
+		notEmpty.wait(lock, [this] { return !items.empty() || closed; });
+		if (items.empty()) return false;
+
+		item = std::move(items.front());
+		items.pop_front();
+		notFull.notify_one();
+		return true;
+	}
+
+	void close() {
+		std::lock_guard<std::mutex> lock(mutex);
+		closed = true;
+		notEmpty.notify_all();
+		notFull.notify_all();
+	}
+};
+
+#endif
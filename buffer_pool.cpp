@@ -0,0 +1,136 @@
+#include "buffer_pool.h"
+#include "memory_governor.h"
+#include "utils.h"
+#include <algorithm>
+#include <cstdint>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+//Transparent huge pages are 2 MB on x86-64 and most ARM64 kernels
+static const size_t HUGE_PAGE_BYTES = 2 * 1024 * 1024;
+static const size_t PAGE_BYTES = 4096;
+
+void adviseHugePages(void* data, size_t bytes) {
+#if !defined(_WIN32) && defined(MADV_HUGEPAGE)
+	if (bytes < HUGE_PAGE_BYTES) return;
+	//madvise takes whole pages: round the start up, the end down
+	uintptr_t start = (reinterpret_cast<uintptr_t>(data) + PAGE_BYTES - 1) / PAGE_BYTES * PAGE_BYTES;
+	uintptr_t end = (reinterpret_cast<uintptr_t>(data) + bytes) / PAGE_BYTES * PAGE_BYTES;
+	if (end > start) {
+		madvise(reinterpret_cast<void*>(start), end - start, MADV_HUGEPAGE);
+	}
+#else
+	(void)data;
+	(void)bytes;
+#endif
+}
+
+//Constructor
+BufferPool::BufferPool(bool huge, MemoryGovernor* governor)
+	: hugePages(huge), memory(governor), idleBytes(0), allocations(0), allocatedBytes(0), reuses(0) {
+}
+
+//Destructor
+BufferPool::~BufferPool() {
+	dropIdle();
+}
+
+//Free every idle buffer (called with the mutex held, or from the destructor)
+void BufferPool::dropIdle() {
+	idle.clear();
+	if (memory) memory->release(idleBytes);
+	idleBytes = 0;
+}
+
+std::vector<int> BufferPool::take(size_t ints) {
+	std::vector<int> buffer;
+	if (ints == 0) return buffer;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		//Best fit keeps the big buffers for the big requests; one more
+		//than twice the size would mostly sit unused
+		size_t best = idle.size();
+		for (size_t i = 0; i < idle.size(); i++) {
+			size_t capacity = idle[i].capacity();
+			if (capacity >= ints && capacity / 2 <= ints
+				&& (best == idle.size() || capacity < idle[best].capacity())) {
+				best = i;
+			}
+		}
+		if (best < idle.size()) {
+			buffer.swap(idle[best]);
+			idle.erase(idle.begin() + best);
+			size_t bytes = buffer.capacity() * sizeof(int);
+			idleBytes -= bytes;
+			if (memory) memory->release(bytes);
+			reuses++;
+			return buffer;
+		}
+
+		//Nothing fits: free the idle ones rather than hold both
+		dropIdle();
+		allocations++;
+		allocatedBytes += ints * sizeof(int);
+	}
+
+	buffer.reserve(ints);
+	if (hugePages) {
+		adviseHugePages(buffer.data(), ints * sizeof(int));
+	}
+	return buffer;
+}
+
+void BufferPool::give(std::vector<int>& buffer) {
+	size_t bytes = buffer.capacity() * sizeof(int);
+	if (bytes < MIN_POOLED_BYTES) {
+		buffer = std::vector<int>();
+		return;
+	}
+	buffer.clear();
+
+	std::lock_guard<std::mutex> lock(mutex);
+	idle.push_back(std::vector<int>());
+	idle.back().swap(buffer);
+	idleBytes += bytes;
+	if (memory) memory->acquire(bytes);
+}
+
+std::string BufferPool::report() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return std::to_string(allocations) + " allocated (" + formatSize(allocatedBytes) + "), "
+		+ std::to_string(reuses) + " reused" + (hugePages ? ", huge pages" : "");
+}
+
+size_t BufferPool::getAllocations() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return allocations;
+}
+
+size_t BufferPool::getReuses() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return reuses;
+}
+
+size_t BufferPool::getIdleBytes() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return idleBytes;
+}
+
+std::vector<int> takeBuffer(BufferPool* pool, size_t ints) {
+	if (pool) return pool->take(ints);
+	std::vector<int> buffer;
+	buffer.reserve(ints);
+	return buffer;
+}
+
+void giveBuffer(BufferPool* pool, std::vector<int>& buffer) {
+	if (pool) {
+		pool->give(buffer);
+	}
+	else {
+		buffer = std::vector<int>();
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class MemoryGovernor;
+
+// Large int buffers recycled across the chunks and phases of one job.
+//
+// Chunk arrays, sort scratch, bucket arrays and the merge's read block
+// storage are taken from the pool and given back when their owner is
+// done, so the next chunk, bucket or merge pass reuses memory that is
+// already faulted in instead of mapping and zeroing fresh pages. With
+// huge pages on, new buffers are advised for transparent huge pages
+// (MADV_HUGEPAGE, Linux only) before they are first touched, which cuts
+// TLB misses on multi-GB arrays. Idle buffers count against the memory
+// governor; when no idle buffer is large enough they are freed before a
+// new one is allocated, so the pool never holds more than the job's
+// largest working set.
+class BufferPool {
+private:
+	bool hugePages;
+	MemoryGovernor* memory;          // Not owned, may be null
+	std::mutex mutex;
+	std::vector<std::vector<int>> idle;
+	size_t idleBytes;
+	size_t allocations;
+	size_t allocatedBytes;
+	size_t reuses;
+
+	void dropIdle();
+
+public:
+	// Smaller buffers are simply freed on give()
+	static constexpr size_t MIN_POOLED_BYTES = 1024 * 1024;
+
+	BufferPool(bool hugePages, MemoryGovernor* memory = nullptr);
+	~BufferPool();
+
+	BufferPool(const BufferPool&) = delete;
+	BufferPool& operator=(const BufferPool&) = delete;
+
+	// An empty buffer with capacity for at least `ints` values: the
+	// smallest idle one that fits (and is at most twice as large), else a
+	// new allocation
+	std::vector<int> take(size_t ints);
+
+	// Hand a buffer back for reuse (leaves `buffer` empty)
+	void give(std::vector<int>& buffer);
+
+	// "3 allocated (96.00 MB), 41 reused[, huge pages]"
+	std::string report();
+
+	//Getters
+	size_t getAllocations();
+	size_t getReuses();
+	size_t getIdleBytes();
+};
+
+// take()/give() on a pool that may be null (plain allocations)
+std::vector<int> takeBuffer(BufferPool* pool, size_t ints);
+void giveBuffer(BufferPool* pool, std::vector<int>& buffer);
+
+// Ask for transparent huge pages on [data, data + bytes) before it is
+// touched; a no-op where unsupported
+void adviseHugePages(void* data, size_t bytes);
+
+#endif
@@ -1,9 +1,23 @@
 #include "chunker.h"
 #include "heap.h"
+#include "sort_strategy.h"
+#include "natural_runs.h"
+#include "run_format.h"
+#include "int_parser.h"
+#include "mapped_input.h"
+#include "bounded_queue.h"
+#include "memory_governor.h"
+#include "temp_files.h"
+#include "buffer_pool.h"
 #include "utils.h"
 #include <iostream>
+#include <iomanip>
 #include <algorithm>
 #include <stdexcept>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -21,90 +35,414 @@ void setColor(int color) {
 #endif
 
 //Constructor
-Chunker::Chunker(const std::string& filename, size_t chunkSize)
-	:inputFilename(filename), chunkSizeBytes(chunkSize), chunkCount(0) {
+Chunker::Chunker(const std::string& filename, size_t chunkSize, const SortOptions& opts)
+	:inputFilename(filename), chunkSizeBytes(chunkSize), chunkCount(0), options(opts),
+	presortedChunks(0), reversedChunks(0), naturalMergeChunks(0), integersSkipped(0), runBytes(0) {
 	maxIntegers = chunkSizeBytes / sizeof(int);
+	if (maxIntegers == 0) maxIntegers = 1;
+	if (options.threadCount < 1) options.threadCount = 1;
 
 	std::cout << " Chunker initialized:\n" ;
 	std::cout << " Chunk size: " << formatSize(chunkSizeBytes) << "\n";
 	std::cout << " Max integers per chunk : " << maxIntegers << "\n";
+	std::cout << " Sort threads: " << options.threadCount << "\n";
+	std::cout << " Chunk sort: " << sortAlgorithmName(options.chunkSort) << "\n";
+	std::cout << " Input reader: " << (options.inputMode == InputMode::Mapped ? "mmap" : "stream") << "\n";
+	if (options.inputSplits > 1) {
+		std::cout << " Input splits: " << options.inputSplits << "\n";
+	}
+	if (options.compressRuns) {
+		std::cout << " Run files: delta + bit-packed\n";
+	}
 }
 
 //Generate temp filename for chunk
 std::string Chunker::getTempFilename(int index) const {
-	return "temp_chunk_" + std::to_string(index) + ".txt";
+	return TempFiles::place(options.temp, "temp_chunk_" + std::to_string(index) + ".run");
+}
+
+//Sort chunk and write to file; returns seconds spent sorting
+double Chunker::sortAndWriteChunk(std::vector<int>& chunk, int index, ChunkSortStrategy& sorter,
+	std::vector<int>& runScratch, MemoryReservation& runScratchMemory) {
+	if (chunk.empty()) return 0;
+
+	Timer sortTimer;
+	NaturalOrder order = NaturalOrder::Unsorted;
+	if (options.adaptiveChunks) {
+		//Sorted, reversed or long natural runs need no full sort
+		size_t runs;
+		//Count the scratch before the sort grows it (up to half the chunk),
+		//then what it holds for as long as the thread keeps it
+		runScratchMemory.reset(std::max(runScratch.capacity(), chunk.size() / 2) * sizeof(int));
+		order = NaturalRunSort::sort(chunk, runScratch, runs);
+		runScratchMemory.reset(runScratch.capacity() * sizeof(int));
+		switch (order) {
+		case NaturalOrder::Ascending: presortedChunks++; break;
+		case NaturalOrder::Descending: reversedChunks++; break;
+		case NaturalOrder::Runs:
+			naturalMergeChunks++;
+			logProgress(" Chunk " + std::to_string(index + 1) + ": merged " + std::to_string(runs)
+				+ " natural runs\n");
+			break;
+		case NaturalOrder::Unsorted: break;
+		}
+	}
+
+	//Sort with the configured strategy
+	if (order == NaturalOrder::Unsorted) {
+		sorter.sort(chunk);
+	}
+	else {
+		integersSkipped += chunk.size();
+	}
+	double sortSeconds = sortTimer.elapsed();
+
+	//Write to temp file as a binary run
+	MemoryReservation writerMemory(options.memory, MemoryGovernor::RUN_WRITER_BYTES);
+	RunWriter out(getTempFilename(index), 64 * 1024, options.compressRuns);
+	out.write(chunk.data(), chunk.size());
+	out.close();
+	runBytes += out.getBytesWritten();
+	return sortSeconds;
 }
 
-//Sort chunk and write to file
-void Chunker::sortAndWriteChunk(std::vector<int>& chunk, int index) {
-	if (chunk.empty()) return;
+//Open the input with the configured reader
+std::unique_ptr<IntParser> Chunker::openInput() const {
+	return openIntInput(inputFilename, options.inputMode);
+}
+
+//Open one byte range of the input with the configured reader
+std::unique_ptr<IntParser> Chunker::openRange(const ByteRange& range) const {
+	return openIntInput(inputFilename, options.inputMode, range);
+}
+
+//Print one progress line; range threads share the console
+void Chunker::logProgress(const std::string& message) {
+	std::lock_guard<std::mutex> lock(logMutex);
+	std::cout << message;
+}
+
+//Read, sort and spill chunks one after another on this thread
+size_t Chunker::createChunksSequential(IntParser& input, ChunkSortStrategy& sorter, double& sortSeconds) {
+	std::vector<int> currentChunk = takeBuffer(options.buffers, maxIntegers);
+	std::vector<int> runScratch;
+	MemoryReservation runScratchMemory(options.memory, 0);
+	size_t totalIntegers = 0;
+	MemoryReservation chunkMemory(options.memory,
+		(maxIntegers + sortScratchInts(sorter.algorithm(), maxIntegers)) * sizeof(int));
 
-	//Sort using Heap Sort
-	Heap::heapSort(chunk);
+	//Read integers from input file, one chunk at a time.
+	//clear() keeps the capacity, so the chunk buffer is allocated once
+	//(or reused from an earlier phase through the buffer pool).
+	while (input.fill(currentChunk, maxIntegers) > 0) {
+		if (currentChunk.size() < maxIntegers) break;
+		totalIntegers += currentChunk.size();
 
-	//Write to temp file
-	std::string filename = getTempFilename(index);
-	std::ofstream out(filename);
+		//When chunk is full , sort an write it
+		int index = chunkCount++;
+		logProgress("Proceesing chunk " + std::to_string(index + 1)
+			+ " (" + std::to_string(currentChunk.size()) + " integers)...\n");
 
-	if (!out.is_open()) {
-		throw std::runtime_error("Cannot create temp file: " + filename);
+		sortSeconds += sortAndWriteChunk(currentChunk, index, sorter, runScratch, runScratchMemory);
+		currentChunk.clear();
 	}
+	totalIntegers += currentChunk.size();
+
+	//Handle remaining data in last chunk
+	if (!currentChunk.empty()) {
+		int index = chunkCount++;
+		logProgress("Processing final chunk" + std::to_string(index + 1)
+			+ " (" + std::to_string(currentChunk.size()) + " integers)...\n");
 
-	for (int value : chunk) {
-		out << value << "\n";
+		sortSeconds += sortAndWriteChunk(currentChunk, index, sorter, runScratch, runScratchMemory);
 	}
-	out.close();
+
+	chunkMemory.reset();
+	runScratchMemory.reset();
+	giveBuffer(options.buffers, currentChunk);
+	giveBuffer(options.buffers, runScratch);
+	return totalIntegers;
 }
 
-//Main operation : create sorted chunks
-std::vector<std::string> Chunker::createSortedChunks() {
-	std::ifstream input(inputFilename);
+//Pipelined chunking: this thread parses chunks into free buffers while
+//worker threads sort and spill the filled ones. The buffer pool is fixed,
+//so memory never exceeds bufferCount chunks.
+size_t Chunker::createChunksParallel(IntParser& input) {
+	struct ChunkJob {
+		int index;
+		std::vector<int>* data;
+	};
 
-	if (!input.is_open()) {
-		throw std::runtime_error("Cannot open input file: " + inputFilename);
+	size_t workers = static_cast<size_t>(options.threadCount);
+	size_t bufferCount = workers + 1;
+	if (options.chunkMemoryBudget > 0) {
+		size_t budgetBuffers = options.chunkMemoryBudget / (maxIntegers * sizeof(int));
+		bufferCount = std::min(bufferCount, std::max<size_t>(budgetBuffers, 2));
 	}
+	std::cout << " Chunk buffers in flight: " << bufferCount
+		<< " (" << formatSize(bufferCount * maxIntegers * sizeof(int)) << ")\n";
 
-	std::vector<std::string> chunkFiles;
-	std::vector<int> currentChunk;
-	currentChunk.reserve(maxIntegers);
+	std::vector<std::vector<int>> buffers(bufferCount);
+	MemoryReservation bufferMemory(options.memory, bufferCount * maxIntegers * sizeof(int));
+	for (auto& buffer : buffers) {
+		buffer = takeBuffer(options.buffers, maxIntegers);
+	}
+	BoundedQueue<std::vector<int>*> freeBuffers(bufferCount);
+	BoundedQueue<ChunkJob> jobs(bufferCount);
+	for (auto& buffer : buffers) {
+		freeBuffers.push(&buffer);
+	}
 
-	Timer timer;
-	size_t totalIntegers = 0;
-	int value;
+	std::mutex errorMutex;
+	std::exception_ptr error;
+	std::atomic<bool> failed(false);
 
-	setColor(COLOR_YELLOW);
-	std::cout << "\n[Chunking Phase]\n";
-	setColor(COLOR_WHITE);
+	auto recordError = [&]() {
+		std::lock_guard<std::mutex> lock(errorMutex);
+		if (!error) error = std::current_exception();
+		failed = true;
+	};
 
-	//Read integers from input file
-	while (input >> value) {
-		currentChunk.push_back(value);
-		totalIntegers++;
+	std::vector<std::thread> pool;
+	for (size_t w = 0; w < workers; w++) {
+		pool.emplace_back([&]() {
+			//Each worker owns its strategy (and any scratch buffer)
+			std::unique_ptr<ChunkSortStrategy> sorter = makeSortStrategy(options.chunkSort, 1, options.buffers);
+			MemoryReservation scratchMemory(options.memory,
+				sortScratchInts(options.chunkSort, maxIntegers) * sizeof(int));
+			std::vector<int> runScratch;
+			MemoryReservation runScratchMemory(options.memory, 0);
+			double sortSeconds = 0;
 
-		//When chunk is full , sort an write it
-		if (currentChunk.size() >= maxIntegers) {
+			ChunkJob job;
+			while (jobs.pop(job)) {
+				try {
+					if (!failed) sortSeconds += sortAndWriteChunk(*job.data, job.index, *sorter, runScratch, runScratchMemory);
+				}
+				catch (...) {
+					recordError();
+				}
+				job.data->clear();
+				freeBuffers.push(job.data);
+			}
+			runScratchMemory.reset();
+			giveBuffer(options.buffers, runScratch);
+
+			std::lock_guard<std::mutex> lock(errorMutex);
+			stats.sortSeconds += sortSeconds;
+		});
+	}
+
+	size_t totalIntegers = 0;
+	try {
+		while (!failed) {
+			std::vector<int>* buffer = nullptr;
+			freeBuffers.pop(buffer);
+			buffer->reserve(maxIntegers);
+
+			input.fill(*buffer, maxIntegers);
+			if (buffer->empty()) {
+				freeBuffers.push(buffer);
+				break;
+			}
+
+			totalIntegers += buffer->size();
 			std::cout << "Proceesing chunk " << (chunkCount + 1)
-				<< " (" << currentChunk.size() << " integers)...\n";
+				<< " (" << buffer->size() << " integers)...\n";
 
-			sortAndWriteChunk(currentChunk, chunkCount);
-			chunkFiles.push_back(getTempFilename(chunkCount));
+			bool last = buffer->size() < maxIntegers;
+			jobs.push(ChunkJob{ chunkCount++, buffer });
+			if (last) break;
+		}
+	}
+	catch (...) {
+		recordError();
+	}
 
-			chunkCount++;
-			currentChunk.clear();
-			currentChunk.reserve(maxIntegers);
+	jobs.close();
+	for (auto& worker : pool) {
+		worker.join();
+	}
+	bufferMemory.reset();
+	for (auto& buffer : buffers) {
+		giveBuffer(options.buffers, buffer);
+	}
+	if (error) {
+		std::rethrow_exception(error);
+	}
+
+	return totalIntegers;
+}
+
+//Replacement selection: stream values through a min-heap of maxIntegers
+//elements. A value >= the last one written still belongs to the current
+//run; smaller values are tagged for the next run and parked until the
+//current run's heap drains. Random input yields runs of ~2x memory,
+//already-sorted input a single run. Heap and parked values together never
+//hold more than maxIntegers elements. Each new heap copies the parked
+//values into its own array and leaves nextRun empty but allocated, so
+//one parking buffer is reused for every run; it and the heap's array are
+//the two maxIntegers-sized buffers reserved below.
+size_t Chunker::createChunksReplacementSelection(IntParser& input) {
+	std::vector<int> nextRun = takeBuffer(options.buffers, maxIntegers);
+	input.fill(nextRun, maxIntegers);
+	size_t totalIntegers = nextRun.size();
+	MemoryReservation heapMemory(options.memory, 2 * maxIntegers * sizeof(int));
+
+	int value;
+	while (!nextRun.empty()) {
+		//Values tagged for the next run become the new heap
+		//The heap copies the values out, so the buffer is refilled as is
+		Heap current(std::move(nextRun));
+		nextRun.clear();
+
+		int index = chunkCount++;
+		MemoryReservation writerMemory(options.memory, MemoryGovernor::RUN_WRITER_BYTES);
+		RunWriter writer(getTempFilename(index), 64 * 1024, options.compressRuns);
+		while (!current.isEmpty()) {
+			int smallest = current.peek();
+			writer.write(smallest);
+
+			//A value that still fits this run takes the written one's place
+			//in a single sift; otherwise the heap shrinks
+			if (input.next(value)) {
+				totalIntegers++;
+				if (value >= smallest) {
+					current.replaceTop(value);
+					continue;
+				}
+				nextRun.push_back(value);
+			}
+			current.pop();
 		}
+		writer.close();
+		runBytes += writer.getBytesWritten();
+
+		logProgress("Proceesing run " + std::to_string(index + 1)
+			+ " (" + std::to_string(writer.getCount()) + " integers)...\n");
 	}
 
-	//Handle remaining data in last chunk
-	if (!currentChunk.empty()) {
-		std::cout << "Processing final chunk" << (chunkCount + 1)
-			<< " (" << currentChunk.size() << " integers)...\n";
+	heapMemory.reset();
+	giveBuffer(options.buffers, nextRun);
+	return totalIntegers;
+}
+
+//Split the input into newline-aligned byte ranges and run chunking on
+//each range in its own thread, so parsing scales with the thread count.
+//Every thread has its own parser and chunk buffer; run indices come from
+//the shared atomic counter, and the Merger only needs the joined list.
+size_t Chunker::createChunksRanges() {
+	//Every range holds one chunk in memory at a time
+	size_t splits = static_cast<size_t>(options.inputSplits);
+	if (options.chunkMemoryBudget > 0) {
+		size_t budgetChunks = options.chunkMemoryBudget / (maxIntegers * sizeof(int));
+		splits = std::min(splits, std::max<size_t>(budgetChunks, 1));
+	}
+
+	std::vector<ByteRange> ranges = FileIO::splitAtNewlines(inputFilename, splits);
+	std::cout << " Input ranges: " << ranges.size() << "\n";
+
+	std::mutex errorMutex;
+	std::exception_ptr error;
+	std::atomic<size_t> totalIntegers(0);
+
+	std::vector<std::thread> pool;
+	for (const ByteRange& range : ranges) {
+		pool.emplace_back([&, range]() {
+			try {
+				std::unique_ptr<IntParser> input = openRange(range);
+				MemoryReservation parseMemory(options.memory,
+					options.inputMode == InputMode::Stream ? MemoryGovernor::PARSE_BUFFER_BYTES : 0);
+				size_t count;
+				double sortSeconds = 0;
+				if (options.runGeneration == RunGeneration::ReplacementSelection) {
+					count = createChunksReplacementSelection(*input);
+				}
+				else {
+					std::unique_ptr<ChunkSortStrategy> sorter = makeSortStrategy(options.chunkSort, 1, options.buffers);
+					count = createChunksSequential(*input, *sorter, sortSeconds);
+				}
+				totalIntegers += count;
+
+				std::lock_guard<std::mutex> lock(errorMutex);
+				stats.sortSeconds += sortSeconds;
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock(errorMutex);
+				if (!error) error = std::current_exception();
+			}
+		});
+	}
+
+	for (auto& worker : pool) {
+		worker.join();
+	}
+	if (error) {
+		std::rethrow_exception(error);
+	}
 
-		sortAndWriteChunk(currentChunk, chunkCount);
-		chunkFiles.push_back(getTempFilename(chunkCount));
-		chunkCount++;
+	return totalIntegers;
+}
+
+//Main operation : create sorted chunks
+std::vector<std::string> Chunker::createSortedChunks() {
+	//Throws if the input file cannot be opened
+	std::unique_ptr<IntParser> parser = openInput();
+	IntParser& input = *parser;
+	MemoryReservation parseMemory(options.memory,
+		options.inputMode == InputMode::Stream ? MemoryGovernor::PARSE_BUFFER_BYTES : 0);
+
+	Timer timer;
+
+	setColor(COLOR_YELLOW);
+	std::cout << "\n[Chunking Phase]\n";
+	setColor(COLOR_WHITE);
+
+	stats = ChunkerStats();
+	presortedChunks = 0;
+	reversedChunks = 0;
+	naturalMergeChunks = 0;
+	integersSkipped = 0;
+	runBytes = 0;
+	size_t totalIntegers;
+	if (options.runGeneration == RunGeneration::ReplacementSelection) {
+		std::cout << " Run generation: replacement selection\n";
+		stats.sortAlgorithm = "replacement selection (heap)";
+	}
+	else {
+		stats.sortAlgorithm = sortAlgorithmName(options.chunkSort);
+	}
+
+	if (options.inputSplits > 1) {
+		parser.reset();
+		parseMemory.reset();
+		totalIntegers = createChunksRanges();
+	}
+	else if (options.runGeneration == RunGeneration::ReplacementSelection) {
+		totalIntegers = createChunksReplacementSelection(input);
+	}
+	else if (options.threadCount > 1 && options.chunkSort != SortAlgorithm::ParallelSampleSort) {
+		totalIntegers = createChunksParallel(input);
+	}
+	else {
+		//Sample sort parallelises inside each chunk instead of across chunks
+		int sortThreads = options.chunkSort == SortAlgorithm::ParallelSampleSort ? options.threadCount : 1;
+		std::unique_ptr<ChunkSortStrategy> sorter = makeSortStrategy(options.chunkSort, sortThreads, options.buffers);
+		totalIntegers = createChunksSequential(input, *sorter, stats.sortSeconds);
+	}
+	stats.totalIntegers = totalIntegers;
+	stats.runs = chunkCount;
+	stats.presortedChunks = presortedChunks;
+	stats.reversedChunks = reversedChunks;
+	stats.naturalMergeChunks = naturalMergeChunks;
+	stats.integersSkipped = integersSkipped;
+	stats.runBytes = runBytes;
+	stats.totalSeconds = timer.elapsed();
+
+	std::vector<std::string> chunkFiles;
+	for (int i = 0; i < chunkCount; i++) {
+		chunkFiles.push_back(getTempFilename(i));
 	}
-	input.close();
 
 	//Summary
 	setColor(COLOR_GREEN);
@@ -112,7 +450,20 @@ std::vector<std::string> Chunker::createSortedChunks() {
 	setColor(COLOR_WHITE);
 	std::cout << " Total integers: " << totalIntegers << "\n";
 	std::cout << " Chunks creates: " << chunkCount << "\n";
-	std::cout << " Time: " << formatTime(timer.elapsed()) << "\n\n";
+	std::cout << " Sort algorithm: " << stats.sortAlgorithm
+		<< " (" << formatTime(stats.sortSeconds) << " sorting)\n";
+	if (options.adaptiveChunks && options.runGeneration == RunGeneration::FixedChunks) {
+		std::cout << " Natural order: " << stats.presortedChunks << " sorted, " << stats.reversedChunks
+			<< " reversed, " << stats.naturalMergeChunks << " run-merged chunks; "
+			<< stats.integersSkipped << " of " << totalIntegers << " integers skipped the sort kernel\n";
+	}
+	if (options.compressRuns && totalIntegers > 0) {
+		std::cout << " Run files: " << formatSize(static_cast<size_t>(stats.runBytes)) << ", "
+			<< std::fixed << std::setprecision(2)
+			<< static_cast<double>(totalIntegers * sizeof(int)) / std::max<uint64_t>(stats.runBytes, 1)
+			<< std::defaultfloat << "x smaller than raw int32\n";
+	}
+	std::cout << " Time: " << formatTime(stats.totalSeconds) << "\n\n";
 
 	return chunkFiles;
  }
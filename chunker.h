@@ -5,6 +5,29 @@
 #include <string>
 #include <vector>
 #include <fstream>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include "sort_options.h"
+#include "file_io.h"
+
+class IntParser;
+class ChunkSortStrategy;
+class MemoryReservation;
+
+// Statistics of the last createSortedChunks() call
+struct ChunkerStats {
+	std::string sortAlgorithm;   // Kernel (or run generation) that produced the runs
+	size_t totalIntegers = 0;
+	int runs = 0;
+	double sortSeconds = 0;      // Time inside the sort kernel, summed over threads
+	int presortedChunks = 0;     // Already sorted: written as read
+	int reversedChunks = 0;      // One descending run: reversed instead of sorted
+	int naturalMergeChunks = 0;  // Few long runs: merged instead of sorted
+	size_t integersSkipped = 0;  // Integers in chunks the sort kernel never saw
+	uint64_t runBytes = 0;       // Size of the run files written (less than 4 bytes a value when packed)
+	double totalSeconds = 0;
+};
 
 // Chunker : Splits large file into sorted chunks
 class Chunker {
@@ -12,15 +35,34 @@ private :
 	std::string inputFilename;
 	size_t chunkSizeBytes;   //Max bytes per chunk
 	size_t maxIntegers;    //Max integers perchunk
-	int chunkCount;
+	std::atomic<int> chunkCount;   //Run indices are handed out from here, also across range threads
+	SortOptions options;
+	ChunkerStats stats;
+	std::mutex logMutex;
+
+	//Natural order found by the adaptive pre-pass, across threads
+	std::atomic<int> presortedChunks;
+	std::atomic<int> reversedChunks;
+	std::atomic<int> naturalMergeChunks;
+	std::atomic<size_t> integersSkipped;
+	std::atomic<uint64_t> runBytes;
 
 	//Helper functions
 	std::string getTempFilename(int index) const;
-	void sortAndWriteChunk(std::vector<int>& chunk, int index);
+	double sortAndWriteChunk(std::vector<int>& chunk, int index, ChunkSortStrategy& sorter,
+		std::vector<int>& runScratch, MemoryReservation& runScratchMemory);
+	std::unique_ptr<IntParser> openInput() const;
+	std::unique_ptr<IntParser> openRange(const ByteRange& range) const;
+	void logProgress(const std::string& message);
+	size_t createChunksSequential(IntParser& input, ChunkSortStrategy& sorter, double& sortSeconds);
+	size_t createChunksParallel(IntParser& input);
+	size_t createChunksReplacementSelection(IntParser& input);
+	size_t createChunksRanges();
 
 public:
 	//Construtor
-	Chunker(const std::string& filenaem, size_t chunkSize = 1 * 1024 * 1024); //1MB
+	Chunker(const std::string& filenaem, size_t chunkSize = 1 * 1024 * 1024, //1MB
+		const SortOptions& options = SortOptions());
 
 	//Main operation: create sorted chunks
 	std::vector<std::string> createSortedChunks();
@@ -28,6 +70,8 @@ public:
 	//Getters
 	int getChunkCount() const { return chunkCount;  }
 	size_t getChunkSize() const { return chunkSizeBytes; }
+	int getThreadCount() const { return options.threadCount; }
+	const ChunkerStats& getStats() const { return stats; }
 
 	//Cleanup temp files
 	void cleanupTempFiles();
@@ -0,0 +1,185 @@
+#include "counting_sort.h"
+#include "input_sample.h"
+#include "mapped_input.h"
+#include "int_writer.h"
+#include "file_io.h"
+#include "memory_governor.h"
+#include "utils.h"
+#include <iostream>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include <limits>
+
+//Histograms always get at least this much, whatever the chunk size
+static const size_t MIN_COUNTING_BUDGET = 64 * 1024 * 1024;
+
+//Values outside the sampled range we are willing to sort on the side
+static const size_t MAX_OUTLIERS = 1024 * 1024;
+
+//Constructor
+CountingSorter::CountingSorter(const std::string& input, const std::string& output, size_t chunkSize,
+	const SortOptions& opts)
+	: inputFilename(input), outputFilename(output), options(opts) {
+	if (options.threadCount < 1) options.threadCount = 1;
+
+	//The overall budget when there is one, else the memory the chunking
+	//phase would have used
+	if (options.memory) {
+		memoryBudget = options.memory->getBudget();
+	}
+	else {
+		size_t chunkBudget = options.chunkMemoryBudget > 0 ? options.chunkMemoryBudget
+			: chunkSize * (options.threadCount + 1);
+		memoryBudget = std::max(chunkBudget, MIN_COUNTING_BUDGET);
+	}
+}
+
+//Parallel histogram: each thread counts one byte range into its own
+//32-bit counts, folded into the 64-bit totals before they can overflow.
+//Returns false when the outliers show the sampled range was wrong.
+bool CountingSorter::count(std::vector<uint64_t>& totals, std::vector<int>& outliers, size_t threads) {
+	std::vector<ByteRange> ranges = FileIO::splitAtNewlines(inputFilename, threads);
+	int64_t lo = stats.minValue;
+	uint64_t width = totals.size();
+
+	std::mutex mutex;
+	std::exception_ptr error;
+	std::atomic<size_t> outlierCount(0);
+	std::atomic<bool> abandoned(false);
+	std::atomic<size_t> totalIntegers(0);
+
+	std::vector<std::thread> workers;
+	for (const ByteRange& range : ranges) {
+		workers.emplace_back([&, range]() {
+			try {
+				std::vector<uint32_t> counts(static_cast<size_t>(width), 0);
+				std::vector<int> localOutliers;
+				std::unique_ptr<IntParser> input = openIntInput(inputFilename, options.inputMode, range);
+
+				//Fold before any 32-bit count can wrap
+				auto fold = [&]() {
+					std::lock_guard<std::mutex> lock(mutex);
+					for (size_t i = 0; i < counts.size(); i++) {
+						totals[i] += counts[i];
+						counts[i] = 0;
+					}
+				};
+				uint64_t sinceFold = 0;
+				size_t parsed = 0;
+
+				int value;
+				while (input->next(value)) {
+					uint64_t slot = static_cast<uint64_t>(static_cast<int64_t>(value) - lo);
+					if (slot < width) {
+						counts[static_cast<size_t>(slot)]++;
+					}
+					else {
+						localOutliers.push_back(value);
+						if (outlierCount++ >= MAX_OUTLIERS) {
+							abandoned = true;
+						}
+					}
+					parsed++;
+					if (++sinceFold == std::numeric_limits<uint32_t>::max()) {
+						fold();
+						sinceFold = 0;
+					}
+					if ((parsed & 0xFFFF) == 0 && abandoned) return;
+				}
+				fold();
+				totalIntegers += parsed;
+
+				std::lock_guard<std::mutex> lock(mutex);
+				outliers.insert(outliers.end(), localOutliers.begin(), localOutliers.end());
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock(mutex);
+				if (!error) error = std::current_exception();
+				abandoned = true;
+			}
+		});
+	}
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+	if (error) {
+		std::rethrow_exception(error);
+	}
+	stats.totalIntegers = totalIntegers;
+	stats.outliers = outliers.size();
+	return !abandoned;
+}
+
+//Write the output from the counts, outliers below and above around them
+void CountingSorter::emit(const std::vector<uint64_t>& totals, std::vector<int>& outliers) {
+	std::sort(outliers.begin(), outliers.end());
+	size_t below = std::lower_bound(outliers.begin(), outliers.end(), static_cast<int>(stats.minValue))
+		- outliers.begin();
+
+	IntWriter output(outputFilename);
+	output.write(outliers.data(), below);
+	for (size_t i = 0; i < totals.size(); i++) {
+		if (totals[i] == 0) continue;
+		output.writeRepeated(static_cast<int>(stats.minValue + static_cast<int64_t>(i)), totals[i]);
+		stats.distinctValues++;
+	}
+	output.write(outliers.data() + below, outliers.size() - below);
+	if (options.syncOutput) {
+		output.sync();
+	}
+	output.close();
+}
+
+//Main operation
+bool CountingSorter::trySort() {
+	stats = CountingStats();
+
+	InputSample sample = sampleInput(inputFilename);
+	if (sample.values.empty()) return false;
+
+	auto bounds = std::minmax_element(sample.values.begin(), sample.values.end());
+	stats.minValue = *bounds.first;
+	stats.maxValue = *bounds.second;
+	uint64_t width = static_cast<uint64_t>(stats.maxValue - stats.minValue) + 1;
+
+	//Summed 64-bit totals, plus one 32-bit histogram per thread (and its
+	//parse buffer, when the budget counts those)
+	uint64_t perThread = width * sizeof(uint32_t);
+	if (options.memory && options.inputMode == InputMode::Stream) {
+		perThread += MemoryGovernor::PARSE_BUFFER_BYTES;
+	}
+	uint64_t shared = width * sizeof(uint64_t);
+	if (shared + perThread > memoryBudget) {
+		std::cout << " Value range " << width << " too wide for counting sort ("
+			<< formatSize(static_cast<size_t>(shared + perThread)) << " of histograms, budget "
+			<< formatSize(memoryBudget) << ")\n";
+		return false;
+	}
+	size_t threads = static_cast<size_t>(std::min<uint64_t>(options.threadCount, (memoryBudget - shared) / perThread));
+	stats.threads = std::max<size_t>(threads, 1);
+
+	std::cout << " Value range [" << stats.minValue << ", " << stats.maxValue << "] from "
+		<< sample.values.size() << " sampled values: counting sort on " << stats.threads << " thread(s)\n";
+
+	Timer countTimer;
+	MemoryReservation histogramMemory(options.memory, static_cast<size_t>(shared + perThread * stats.threads));
+	std::vector<uint64_t> totals(static_cast<size_t>(width), 0);
+	std::vector<int> outliers;
+	if (!count(totals, outliers, stats.threads)) {
+		std::cout << " More than " << MAX_OUTLIERS << " values outside the sampled range: "
+			<< "falling back to the general sort\n";
+		return false;
+	}
+	stats.countSeconds = countTimer.elapsed();
+
+	Timer emitTimer;
+	histogramMemory.reset(static_cast<size_t>(shared) + outliers.size() * sizeof(int)
+		+ MemoryGovernor::INT_WRITER_BYTES);
+	emit(totals, outliers);
+	stats.emitSeconds = emitTimer.elapsed();
+	stats.used = true;
+	return true;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#ifndef COUNTING_SORT_H
+#define COUNTING_SORT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "sort_options.h"
+
+// Statistics of the last CountingSorter::trySort() call
+struct CountingStats {
+	bool used = false;
+	int64_t minValue = 0;         // Histogram covers [minValue, maxValue]
+	int64_t maxValue = 0;
+	size_t threads = 0;
+	size_t totalIntegers = 0;
+	size_t outliers = 0;          // Values outside the histogram, sorted separately
+	size_t distinctValues = 0;
+	double countSeconds = 0;
+	double emitSeconds = 0;
+};
+
+// CountingSorter: one-pass sort for inputs with a narrow value range.
+//
+// A sample of the input gives the value range. When a histogram of that
+// range fits the memory budget, threads count newline-aligned byte ranges
+// of the input into their own histograms, and the output is written
+// straight from the summed counts: no temp runs and no merge. Values the
+// sample missed are kept aside and sorted; if there are too many of them,
+// the range guess was wrong and the caller falls back to chunk/merge.
+class CountingSorter {
+private:
+	std::string inputFilename;
+	std::string outputFilename;
+	SortOptions options;
+	size_t memoryBudget;          //Bytes the histograms may use
+	CountingStats stats;
+
+	//Helper functions
+	bool count(std::vector<uint64_t>& totals, std::vector<int>& outliers, size_t threads);
+	void emit(const std::vector<uint64_t>& totals, std::vector<int>& outliers);
+
+public:
+	//Constructor
+	CountingSorter(const std::string& input, const std::string& output, size_t chunkSize,
+		const SortOptions& options = SortOptions());
+
+	// Sort the input if its value range is narrow enough; returns false
+	// (and writes nothing) when the general path is needed
+	bool trySort();
+
+	//Getters
+	const CountingStats& getStats() const { return stats; }
+};
+
+#endif
@@ -0,0 +1,350 @@
+#include "distributor.h"
+#include "input_sample.h"
+#include "mapped_input.h"
+#include "sort_strategy.h"
+#include "run_format.h"
+#include "int_writer.h"
+#include "merger.h"
+#include "memory_governor.h"
+#include "temp_files.h"
+#include "buffer_pool.h"
+#include "file_io.h"
+#include "utils.h"
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+//Scatter write buffers, shared by all buckets
+static const size_t SCATTER_BUFFER_BYTES = 16 * 1024 * 1024;
+static const size_t MIN_SCATTER_BUFFER = 4 * 1024;
+static const size_t MAX_SCATTER_BUFFER = 256 * 1024;
+
+//Values parsed per scatter batch
+static const size_t SCATTER_BATCH = 64 * 1024;
+
+//Constructor
+Distributor::Distributor(const std::string& input, const std::string& output, size_t chunkSize,
+	const SortOptions& opts)
+	: inputFilename(input), outputFilename(output), options(opts) {
+	maxIntegers = chunkSize / sizeof(int);
+	if (maxIntegers == 0) maxIntegers = 1;
+	if (options.threadCount < 1) options.threadCount = 1;
+
+	std::cout << " Distributor initialized:\n";
+	std::cout << " Bucket memory: " << formatSize(maxIntegers * sizeof(int)) << " (" << maxIntegers << " integers)\n";
+	std::cout << " Sort threads: " << options.threadCount << "\n";
+	std::cout << " Bucket sort: " << sortAlgorithmName(options.chunkSort) << "\n";
+}
+
+//Destructor
+Distributor::~Distributor() {
+	for (size_t b = 0; b < bucketSizes.size(); b++) {
+		std::remove(getBucketFilename(b).c_str());
+	}
+}
+
+//Temp file for a bucket's unsorted values
+std::string Distributor::getBucketFilename(size_t bucket) const {
+	return TempFiles::place(options.temp, "temp_bucket_" + std::to_string(bucket) + ".run");
+}
+
+//Temp file for one sorted run of an overflowing bucket
+std::string Distributor::getOverflowFilename(size_t bucket, size_t part) const {
+	return TempFiles::place(options.temp, "temp_bucket_" + std::to_string(bucket) + "_part_" + std::to_string(part) + ".run");
+}
+
+//Buckets of about half a chunk leave room for sampling error, bounded
+//by the files we may keep open while scattering
+size_t Distributor::chooseBucketCount(uint64_t estimatedCount) const {
+	if (options.bucketCount > 0) return options.bucketCount;
+
+	uint64_t target = std::max<uint64_t>(maxIntegers / 2, 1);
+	uint64_t buckets = (estimatedCount + target - 1) / target;
+	size_t fileLimit = FileIO::maxOpenFiles();
+	size_t maxBuckets = fileLimit > 32 ? fileLimit - 16 : 16;
+	return static_cast<size_t>(std::max<uint64_t>(std::min<uint64_t>(buckets, maxBuckets), 1));
+}
+
+//Bucket boundaries at the sample quantiles; repeated keys give repeated
+//splitters, and the buckets between them simply stay empty
+void Distributor::chooseSplitters(std::vector<int>& sample, size_t buckets) {
+	splitters.clear();
+	std::sort(sample.begin(), sample.end());
+	if (sample.empty()) return;
+	for (size_t b = 1; b < buckets; b++) {
+		splitters.push_back(sample[sample.size() * b / buckets]);
+	}
+}
+
+//One pass over the input: append every value to its bucket's run
+size_t Distributor::scatter() {
+	size_t buckets = splitters.size() + 1;
+	size_t bufferBytes = std::min(std::max(SCATTER_BUFFER_BYTES / buckets, MIN_SCATTER_BUFFER), MAX_SCATTER_BUFFER);
+
+	MemoryReservation scatterMemory(options.memory, bufferBytes / sizeof(int) * sizeof(int) * buckets
+		+ SCATTER_BATCH * sizeof(int)
+		+ (options.inputMode == InputMode::Stream ? MemoryGovernor::PARSE_BUFFER_BYTES : 0));
+	std::vector<std::unique_ptr<RunWriter>> writers;
+	bucketSizes.assign(buckets, 0);
+	for (size_t b = 0; b < buckets; b++) {
+		writers.emplace_back(new RunWriter(getBucketFilename(b), bufferBytes / sizeof(int)));
+	}
+
+	std::unique_ptr<IntParser> input = openIntInput(inputFilename, options.inputMode);
+	std::vector<int> batch;
+	batch.reserve(SCATTER_BATCH);
+	size_t totalIntegers = 0;
+	while (input->fill(batch, SCATTER_BATCH) > 0) {
+		for (int value : batch) {
+			size_t b = std::upper_bound(splitters.begin(), splitters.end(), value) - splitters.begin();
+			writers[b]->write(value);
+			bucketSizes[b]++;
+		}
+		totalIntegers += batch.size();
+		batch.clear();
+	}
+
+	for (auto& writer : writers) {
+		writer->close();
+	}
+	return totalIntegers;
+}
+
+//Chunk/merge fallback for a bucket bigger than memory: sorted runs of
+//maxIntegers, merged into a text segment that is returned
+std::string Distributor::sortOverflowBucket(size_t bucket, double& sortSeconds) {
+	std::cout << " Bucket " << bucket << " overflows memory (" << bucketSizes[bucket]
+		<< " integers): sorting it by chunk/merge\n";
+
+	std::unique_ptr<ChunkSortStrategy> sorter = makeSortStrategy(options.chunkSort, options.threadCount, options.buffers);
+	MemoryReservation chunkMemory(options.memory,
+		(maxIntegers + sortScratchInts(options.chunkSort, maxIntegers)) * sizeof(int));
+	std::vector<int> chunk = takeBuffer(options.buffers, maxIntegers);
+	chunk.resize(maxIntegers);
+	std::vector<std::string> parts;
+	RunReader reader(getBucketFilename(bucket));
+	MemoryReservation writerMemory(options.memory, MemoryGovernor::RUN_WRITER_BYTES);
+	size_t count;
+	while ((count = reader.read(chunk.data(), maxIntegers)) > 0) {
+		chunk.resize(count);
+		Timer sortTimer;
+		sorter->sort(chunk);
+		sortSeconds += sortTimer.elapsed();
+
+		parts.push_back(getOverflowFilename(bucket, parts.size()));
+		RunWriter out(parts.back(), 64 * 1024, options.compressRuns);
+		out.write(chunk.data(), chunk.size());
+		out.close();
+		chunk.resize(maxIntegers);
+	}
+	reader.close();
+	std::remove(getBucketFilename(bucket).c_str());
+	chunkMemory.reset();
+	giveBuffer(options.buffers, chunk);
+	sorter.reset();
+	writerMemory.reset();
+
+	std::string segment = TempFiles::place(options.temp, "temp_bucket_" + std::to_string(bucket) + ".txt");
+	try {
+		Merger merger(parts, segment, options);
+		merger.merge();
+	}
+	catch (...) {
+		for (const std::string& part : parts) std::remove(part.c_str());
+		throw;
+	}
+	for (const std::string& part : parts) std::remove(part.c_str());
+	return segment;
+}
+
+//Workers load and sort buckets ahead of the writer, at most `window`
+//buckets in memory; this thread writes them out in bucket order
+void Distributor::sortBuckets() {
+	struct Slot {
+		std::vector<int> data;
+		MemoryReservation memory;
+		bool ready = false;
+		bool overflow = false;
+	};
+
+	size_t buckets = bucketSizes.size();
+	size_t workerCount = static_cast<size_t>(options.threadCount);
+	size_t window = workerCount + 1;
+	if (options.chunkMemoryBudget > 0) {
+		size_t budgetBuckets = options.chunkMemoryBudget / (maxIntegers * sizeof(int));
+		window = std::min(window, std::max<size_t>(budgetBuckets, 1));
+	}
+	workerCount = std::min(workerCount, window);
+
+	std::vector<Slot> slots(buckets);
+	std::mutex mutex;
+	std::condition_variable readyCv;    //Signals the writer
+	std::condition_variable windowCv;   //Signals the workers
+	std::atomic<size_t> nextBucket(0);
+	size_t written = 0;
+	std::exception_ptr error;
+	double overflowSortSeconds = 0;
+
+	std::vector<std::thread> workers;
+	for (size_t w = 0; w < workerCount; w++) {
+		workers.emplace_back([&]() {
+			std::unique_ptr<ChunkSortStrategy> sorter = makeSortStrategy(options.chunkSort, 1, options.buffers);
+			MemoryReservation scratchMemory(options.memory,
+				sortScratchInts(options.chunkSort, maxIntegers) * sizeof(int));
+			double sortSeconds = 0;
+			try {
+				for (;;) {
+					size_t b = nextBucket++;
+					if (b >= buckets) break;
+					{
+						std::unique_lock<std::mutex> lock(mutex);
+						windowCv.wait(lock, [&]() { return b < written + window || error; });
+						if (error) break;
+					}
+
+					//Too big to sort here: the writer handles it in order
+					std::vector<int> data;
+					MemoryReservation dataMemory;
+					bool overflow = bucketSizes[b] > maxIntegers;
+					if (!overflow && bucketSizes[b] > 0) {
+						dataMemory = MemoryReservation(options.memory, static_cast<size_t>(bucketSizes[b]) * sizeof(int));
+						data = takeBuffer(options.buffers, static_cast<size_t>(bucketSizes[b]));
+						data.resize(static_cast<size_t>(bucketSizes[b]));
+						RunReader reader(getBucketFilename(b));
+						if (reader.read(data.data(), data.size()) != data.size()) {
+							throw std::runtime_error("Truncated bucket file: " + getBucketFilename(b));
+						}
+						reader.close();
+						std::remove(getBucketFilename(b).c_str());
+
+						Timer sortTimer;
+						sorter->sort(data);
+						sortSeconds += sortTimer.elapsed();
+					}
+
+					std::lock_guard<std::mutex> lock(mutex);
+					slots[b].data.swap(data);
+					slots[b].memory = std::move(dataMemory);
+					slots[b].overflow = overflow;
+					slots[b].ready = true;
+					readyCv.notify_all();
+				}
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock(mutex);
+				if (!error) error = std::current_exception();
+				readyCv.notify_all();
+				windowCv.notify_all();
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			stats.sortSeconds += sortSeconds;
+		});
+	}
+
+	try {
+		MemoryReservation outputMemory(options.memory, MemoryGovernor::INT_WRITER_BYTES);
+		IntWriter output(outputFilename);
+		for (size_t b = 0; b < buckets; b++) {
+			std::vector<int> data;
+			MemoryReservation dataMemory;
+			bool overflow;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				readyCv.wait(lock, [&]() { return slots[b].ready || error; });
+				if (error) break;
+				data.swap(slots[b].data);
+				dataMemory = std::move(slots[b].memory);
+				overflow = slots[b].overflow;
+			}
+
+			if (overflow) {
+				std::string segment = sortOverflowBucket(b, overflowSortSeconds);
+				output.append(segment);
+				std::remove(segment.c_str());
+				stats.overflowBuckets++;
+			}
+			else {
+				output.write(data.data(), data.size());
+				dataMemory.reset();
+				giveBuffer(options.buffers, data);
+			}
+
+			std::lock_guard<std::mutex> lock(mutex);
+			written++;
+			windowCv.notify_all();
+		}
+		if (options.syncOutput) {
+			output.sync();
+		}
+		output.close();
+	}
+	catch (...) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!error) error = std::current_exception();
+		windowCv.notify_all();
+	}
+
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+	stats.sortSeconds += overflowSortSeconds;
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
+
+//Main operation
+void Distributor::sort() {
+	Timer timer;
+	stats = DistributionStats();
+
+	std::cout << "\n[Sampling]\n";
+	InputSample sample = sampleInput(inputFilename);
+	uint64_t estimate = sample.estimateCount();
+	size_t buckets = chooseBucketCount(estimate);
+	chooseSplitters(sample.values, buckets);
+	std::cout << " Sampled " << sample.values.size() << " values, about " << estimate
+		<< " integers in " << formatSize(sample.fileBytes) << "\n";
+	std::cout << " Buckets: " << buckets << "\n";
+
+	std::cout << "\n[Scatter Phase]\n";
+	Timer scatterTimer;
+	stats.totalIntegers = scatter();
+	stats.scatterSeconds = scatterTimer.elapsed();
+	stats.buckets = buckets;
+	for (uint64_t size : bucketSizes) {
+		stats.largestBucket = std::max<size_t>(stats.largestBucket, static_cast<size_t>(size));
+	}
+	std::cout << " Scattered " << stats.totalIntegers << " integers into " << buckets << " buckets in "
+		<< formatTime(stats.scatterSeconds) << "\n";
+	std::cout << " Largest bucket: " << stats.largestBucket << " integers (average "
+		<< stats.totalIntegers / buckets << ")\n";
+
+	std::cout << "\n[Bucket Sort Phase]\n";
+	sortBuckets();
+	stats.totalSeconds = timer.elapsed();
+
+	std::cout << "Distribution Sort Complete!\n";
+	std::cout << " Output file: " << outputFilename << "\n";
+	if (stats.overflowBuckets > 0) {
+		std::cout << " Buckets sorted by chunk/merge: " << stats.overflowBuckets << "\n";
+	}
+	std::cout << " Sort algorithm: " << sortAlgorithmName(options.chunkSort)
+		<< " (" << formatTime(stats.sortSeconds) << " sorting)\n";
+	std::cout << " Time: " << formatTime(stats.totalSeconds) << "\n\n";
+}
+
+//Cleanup temporary bucket files
+void Distributor::cleanupTempFiles() {
+	size_t removed = 0;
+	for (size_t b = 0; b < bucketSizes.size(); b++) {
+		if (std::remove(getBucketFilename(b).c_str()) == 0) removed++;
+	}
+	std::cout << " Removed " << removed << " leftover bucket files\n";
+}
@@ -0,0 +1,68 @@
+#pragma once
+#ifndef DISTRIBUTOR_H
+#define DISTRIBUTOR_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "sort_options.h"
+
+// Statistics of the last Distributor run
+struct DistributionStats {
+	size_t totalIntegers = 0;
+	size_t buckets = 0;
+	size_t overflowBuckets = 0;   // Too big for memory: sorted by chunk/merge
+	size_t largestBucket = 0;
+	double scatterSeconds = 0;
+	double sortSeconds = 0;       // Time inside the sort kernel, summed over threads
+	double totalSeconds = 0;
+};
+
+// Distributor: range-partitioned (sample) sort of a whole file.
+//
+// A sample of the input picks bucket boundaries so each bucket holds
+// about half a chunk. One pass scatters every value into its bucket's
+// temp run, then worker threads load and sort whole buckets in memory
+// while this thread writes them to the output in key order. There is no
+// global merge. A bucket that skew made bigger than a chunk is sorted the
+// chunk/merge way instead: cut into sorted runs, merged by Merger, and
+// spliced into the output at its place.
+class Distributor {
+private:
+	std::string inputFilename;
+	std::string outputFilename;
+	size_t maxIntegers;           //Largest bucket sorted in memory
+	SortOptions options;
+	DistributionStats stats;
+
+	std::vector<int> splitters;   //Bucket b holds [splitters[b-1], splitters[b])
+	std::vector<uint64_t> bucketSizes;
+
+	//Helper functions
+	std::string getBucketFilename(size_t bucket) const;
+	std::string getOverflowFilename(size_t bucket, size_t part) const;
+	size_t chooseBucketCount(uint64_t estimatedCount) const;
+	void chooseSplitters(std::vector<int>& sample, size_t buckets);
+	size_t scatter();
+	void sortBuckets();
+	std::string sortOverflowBucket(size_t bucket, double& sortSeconds);
+
+public:
+	//Constructor
+	Distributor(const std::string& input, const std::string& output, size_t chunkSize,
+		const SortOptions& options = SortOptions());
+
+	//Destructor (removes any bucket files left behind)
+	~Distributor();
+
+	//Main operation: sample, scatter, sort buckets into the output
+	void sort();
+
+	//Getters
+	const DistributionStats& getStats() const { return stats; }
+
+	//Cleanup temp files
+	void cleanupTempFiles();
+};
+
+#endif
@@ -2,9 +2,17 @@
 #include <fstream>
 #include <cstdio>
 #include <sys/stat.h>
+#include <algorithm>
+#include <stdexcept>
 
 #ifdef _WIN32
 #include <direct.h> 
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <sys/statvfs.h>
+#include <sys/resource.h>
 #endif
 
 bool FileIO::exists(const std::string& filename) {
@@ -24,10 +32,106 @@ void FileIO::deleteFile(const std::string& filename) {
     }
 }
 
-void FileIO::makeDirectory(const std::string& path) {
+bool FileIO::makeDirectory(const std::string& path) {
+#ifdef _WIN32
+    return _mkdir(path.c_str()) == 0;
+#else
+    return mkdir(path.c_str(), 0777) == 0;
+#endif
+}
+
+void FileIO::removeDirectory(const std::string& path) {
+#ifdef _WIN32
+    _rmdir(path.c_str());
+#else
+    rmdir(path.c_str());
+#endif
+}
+
+uint64_t FileIO::freeSpace(const std::string& path) {
+#ifdef _WIN32
+    ULARGE_INTEGER available;
+    if (!GetDiskFreeSpaceExA(path.c_str(), &available, NULL, NULL)) return 0;
+    return static_cast<uint64_t>(available.QuadPart);
+#else
+    struct statvfs info;
+    if (statvfs(path.c_str(), &info) != 0) return 0;
+    return static_cast<uint64_t>(info.f_bavail) * info.f_frsize;
+#endif
+}
+
+bool FileIO::seek(std::FILE* file, uint64_t offset) {
+#ifdef _WIN32
+    return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+size_t FileIO::maxOpenFiles() {
+#ifdef _WIN32
+    return static_cast<size_t>(_getmaxstdio());
+#else
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0 || limit.rlim_cur == RLIM_INFINITY) {
+        return 1024;
+    }
+    return static_cast<size_t>(limit.rlim_cur);
+#endif
+}
+
+bool FileIO::syncData(std::FILE* file) {
+    if (std::fflush(file) != 0) return false;
 #ifdef _WIN32
-    _mkdir(path.c_str());
+    return _commit(_fileno(file)) == 0;
+#elif defined(__APPLE__)
+    return fsync(fileno(file)) == 0;
 #else
-    mkdir(path.c_str(), 0777);
+    return fdatasync(fileno(file)) == 0;
 #endif
+}
+
+std::vector<ByteRange> FileIO::splitAtNewlines(const std::string& filename, size_t parts) {
+    std::vector<ByteRange> ranges;
+    uint64_t size = getFileSize(filename);
+    if (size == 0) return ranges;
+    if (parts == 0) parts = 1;
+
+    std::FILE* file = std::fopen(filename.c_str(), "rb");
+    if (!file) {
+        throw std::runtime_error("Cannot open input file: " + filename);
+    }
+
+    // Boundary k starts at k*size/parts, then moves past the next '\n'
+    std::vector<uint64_t> boundaries;
+    boundaries.push_back(0);
+    char buffer[4096];
+    for (size_t k = 1; k < parts; k++) {
+        uint64_t pos = std::max(boundaries.back(), size * k / parts);
+        if (pos == 0 || pos >= size) continue;
+
+        // Start one byte early: a range may begin right after a newline
+        uint64_t scan = pos - 1;
+        uint64_t boundary = size;
+        if (!seek(file, scan)) break;
+        size_t got;
+        while (boundary == size && (got = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            for (size_t i = 0; i < got; i++) {
+                if (buffer[i] == '\n') {
+                    boundary = scan + i + 1;
+                    break;
+                }
+            }
+            scan += got;
+        }
+        if (boundary >= size) break;
+        if (boundary > boundaries.back()) boundaries.push_back(boundary);
+    }
+    std::fclose(file);
+
+    boundaries.push_back(size);
+    for (size_t i = 0; i + 1 < boundaries.size(); i++) {
+        ranges.push_back(ByteRange{ boundaries[i], boundaries[i + 1] - boundaries[i] });
+    }
+    return ranges;
 }
\ No newline at end of file
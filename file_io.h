@@ -3,6 +3,15 @@
 #define FILE_IO_H
 
 #include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+
+// Contiguous slice of a file
+struct ByteRange {
+    uint64_t offset;
+    uint64_t length;
+};
 
 class FileIO {
 public:
@@ -15,8 +24,29 @@ public:
     // Safely delete a file
     static void deleteFile(const std::string& filename);
 
-    // Create a directory (useful for temp folders)
-    static void makeDirectory(const std::string& path);
+    // Create a directory (useful for temp folders); false if it already
+    // exists or cannot be created
+    static bool makeDirectory(const std::string& path);
+
+    // Remove an empty directory
+    static void removeDirectory(const std::string& path);
+
+    // Bytes free for this user on the volume holding path (0 if unknown)
+    static uint64_t freeSpace(const std::string& path);
+
+    // Seek an open file to a 64-bit offset; returns false on failure
+    static bool seek(std::FILE* file, uint64_t offset);
+
+    // Number of files this process may have open at once
+    static size_t maxOpenFiles();
+
+    // Flush stdio and force the file's data to disk (fdatasync); returns false on failure
+    static bool syncData(std::FILE* file);
+
+    // Split a text file into up to `parts` ranges of similar size. Each
+    // boundary is moved forward to just past the next newline, so no line
+    // is cut in two. Empty ranges are dropped.
+    static std::vector<ByteRange> splitAtNewlines(const std::string& filename, size_t parts);
 };
 
 #endif
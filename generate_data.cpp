@@ -1,7 +1,8 @@
 #include <iostream>
-#include <fstream>
 #include <random>
 #include <string>
+#include <stdexcept>
+#include "int_writer.h"
 
 int main(int argc, char* argv[]) {
     size_t count = 1000000;
@@ -17,22 +18,25 @@ int main(int argc, char* argv[]) {
 
     std::cout << "Generating " << count << " random integers...\n";
 
-    std::ofstream out(filename);
-    if (!out.is_open()) {
-        std::cerr << "Cannot create file: " << filename << "\n";
-        return 1;
-    }
+    try {
+        IntWriter out(filename);
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(-1000000, 1000000);
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_int_distribution<> dis(-1000000, 1000000);
 
-    for (size_t i = 0; i < count; i++) {
-        out << dis(gen) << "\n";
+        for (size_t i = 0; i < count; i++) {
+            out.write(dis(gen));
 
-        if (i % 100000 == 0) {
-            std::cout << "\r" << (i * 100 / count) << "%" << std::flush;
+            if (i % 100000 == 0) {
+                std::cout << "\r" << (i * 100 / count) << "%" << std::flush;
+            }
         }
+        out.close();
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
     }
 
     std::cout << "\r100%\n";
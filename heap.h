@@ -3,36 +3,247 @@
 #define HEAP_H
 
 #include <vector>
+#include <functional>
+#include <iterator>
+#include <utility>
 #include <stdexcept>
+#include "aligned_allocator.h"
+
+// d-ary heap over T. The element for which compare(a, b) holds against
+// every other element is on top, so the default std::less gives a
+// min-heap (the opposite of std::priority_queue).
+//
+// Storage is cache-line aligned and offset by Arity - 1 slots, so the
+// Arity children of a node always start on an Arity-element boundary:
+// for 4- and 8-ary heaps of ints a sift-down step reads one cache line.
+// Sifts are iterative and move a hole instead of swapping.
+template <typename T, typename Compare = std::less<T>, size_t Arity = 4>
+class DaryHeap {
+	static_assert(Arity >= 2, "A heap needs at least two children per node");
 
-// Min-Heap implementation for heap sort
-class Heap {
 private:
-	std::vector<int> data;
+	static constexpr size_t PAD = Arity - 1;
+
+	std::vector<T, AlignedAllocator<T>> slots;   // PAD unused slots, then the heap
+	Compare compare;
 
 	// Helper functions
-	int parent(int i) const { return (i - 1) / 2; }
-	int leftChild(int i) const { return 2 * i + 1; }
-	int rightChild(int i) const { return 2 * i + 2; }
+	T* base() { return slots.data() + PAD; }
+	static size_t parent(size_t i) { return (i - 1) / Arity; }
+	static size_t firstChild(size_t i) { return Arity * i + 1; }
+
+	void heapifyDown(size_t index);
+	void heapifyUp(size_t index);
+	void heapifyAll();
 
-	void heapifyDown(int index);
-	void heapifyUp(int index);
+	// Heap sort helper: sift down a max-heap (under compare) of n elements
+	static void heapifyDownForSort(T* arr, size_t n, size_t i, Compare& compare);
 
 public:
-	Heap();
-	explicit Heap(const std::vector<int>& arr);
-	void insert(int value);
-	int extractMin();
-	int peek() const;
-	bool isEmpty() const { return data.empty(); }
-	size_t size() const { return data.size(); }
+	explicit DaryHeap(const Compare& comp = Compare()) : slots(PAD), compare(comp) {}
+	explicit DaryHeap(const std::vector<T>& arr, const Compare& comp = Compare());
+	explicit DaryHeap(std::vector<T>&& arr, const Compare& comp = Compare());
 
-	// Static heap sort function (ascending order)
-	static void heapSort(std::vector<int>& arr);
+	// Replace the contents with [first, last) and heapify in O(n)
+	template <typename Iterator>
+	void buildHeap(Iterator first, Iterator last);
 
-private:
-	// Static heap sort function (ascending order)
-	static void  heapifyDownForSort(std::vector<int>& arr, int n, int i);
+	void insert(const T& value);
+	T extractMin();
+	const T& peek() const;
+
+	// Drop the top element
+	void pop();
+
+	// Overwrite the top element and restore the heap with a single sift;
+	// the same result as pop() + insert(value) at half the cost
+	void replaceTop(const T& value);
+
+	bool isEmpty() const { return slots.size() == PAD; }
+	size_t size() const { return slots.size() - PAD; }
+	void reserve(size_t count) { slots.reserve(PAD + count); }
+	void clear() { slots.resize(PAD); }
+
+	// Static heap sort function (ascending under compare)
+	static void heapSort(std::vector<T>& arr);
 };
 
+// Min-Heap of ints used by heap sort and replacement selection
+typedef DaryHeap<int> Heap;
+
+// ---------------- DaryHeap ----------------
+
+template <typename T, typename Compare, size_t Arity>
+DaryHeap<T, Compare, Arity>::DaryHeap(const std::vector<T>& arr, const Compare& comp)
+	: compare(comp) {
+	buildHeap(arr.begin(), arr.end());
+}
+
+template <typename T, typename Compare, size_t Arity>
+DaryHeap<T, Compare, Arity>::DaryHeap(std::vector<T>&& arr, const Compare& comp)
+	: compare(comp) {
+	buildHeap(std::make_move_iterator(arr.begin()), std::make_move_iterator(arr.end()));
+	arr.clear();
+}
+
+template <typename T, typename Compare, size_t Arity>
+template <typename Iterator>
+void DaryHeap<T, Compare, Arity>::buildHeap(Iterator first, Iterator last) {
+	slots.clear();
+	slots.resize(PAD);
+	slots.insert(slots.end(), first, last);
+	heapifyAll();
+}
+
+// Floyd's bottom-up build: sift every internal node, last one first
+template <typename T, typename Compare, size_t Arity>
+void DaryHeap<T, Compare, Arity>::heapifyAll() {
+	size_t n = size();
+	if (n < 2) return;
+	for (size_t i = parent(n - 1) + 1; i-- > 0;) {
+		heapifyDown(i);
+	}
+}
+
+// Insert element into heap
+template <typename T, typename Compare, size_t Arity>
+void DaryHeap<T, Compare, Arity>::insert(const T& value) {
+	slots.push_back(value);
+	heapifyUp(size() - 1);
+}
+
+// Extract top element
+template <typename T, typename Compare, size_t Arity>
+T DaryHeap<T, Compare, Arity>::extractMin() {
+	if (isEmpty()) {
+		throw std::runtime_error("Heap is empty");
+	}
+
+	T top = std::move(base()[0]);
+	pop();
+	return top;
+}
+
+// Peek at top element
+template <typename T, typename Compare, size_t Arity>
+const T& DaryHeap<T, Compare, Arity>::peek() const {
+	if (isEmpty()) {
+		throw std::runtime_error("Heap is empty");
+	}
+	return slots[PAD];
+}
+
+template <typename T, typename Compare, size_t Arity>
+void DaryHeap<T, Compare, Arity>::pop() {
+	if (isEmpty()) {
+		throw std::runtime_error("Heap is empty");
+	}
+
+	// Move last element to root and restore heap property
+	if (size() > 1) {
+		base()[0] = std::move(slots.back());
+		slots.pop_back();
+		heapifyDown(0);
+	}
+	else {
+		slots.pop_back();
+	}
+}
+
+template <typename T, typename Compare, size_t Arity>
+void DaryHeap<T, Compare, Arity>::replaceTop(const T& value) {
+	if (isEmpty()) {
+		throw std::runtime_error("Heap is empty");
+	}
+	base()[0] = value;
+	heapifyDown(0);
+}
+
+// Heapify down: move a hole from index towards the leaves
+template <typename T, typename Compare, size_t Arity>
+void DaryHeap<T, Compare, Arity>::heapifyDown(size_t index) {
+	T* heap = base();
+	size_t n = size();
+	T value = std::move(heap[index]);
+
+	for (;;) {
+		size_t first = firstChild(index);
+		if (first >= n) break;
+
+		// Find the best child; a full sibling group needs no bounds checks
+		size_t best = first;
+		size_t last = first + Arity <= n ? first + Arity : n;
+		for (size_t child = first + 1; child < last; child++) {
+			if (compare(heap[child], heap[best])) best = child;
+		}
+
+		if (!compare(heap[best], value)) break;
+		heap[index] = std::move(heap[best]);
+		index = best;
+	}
+	heap[index] = std::move(value);
+}
+
+// Heapify up (for insertion)
+template <typename T, typename Compare, size_t Arity>
+void DaryHeap<T, Compare, Arity>::heapifyUp(size_t index) {
+	T* heap = base();
+	T value = std::move(heap[index]);
+
+	while (index > 0) {
+		size_t parentIdx = parent(index);
+		if (!compare(value, heap[parentIdx])) break;
+		heap[index] = std::move(heap[parentIdx]);
+		index = parentIdx;
+	}
+	heap[index] = std::move(value);
+}
+
+// Static heap sort function: in place, Arity-ary max-heap
+template <typename T, typename Compare, size_t Arity>
+void DaryHeap<T, Compare, Arity>::heapSort(std::vector<T>& arr) {
+	size_t n = arr.size();
+	if (n < 2) return;
+	Compare compare;
+
+	// Build max-heap (for ascending sort)
+	for (size_t i = parent(n - 1) + 1; i-- > 0;) {
+		heapifyDownForSort(arr.data(), n, i, compare);
+	}
+
+	// Extract elements one by one
+	for (size_t i = n - 1; i > 0; i--) {
+		// Move current root (maximum) to end
+		std::swap(arr[0], arr[i]);
+
+		// Heapify reduced heap
+		heapifyDownForSort(arr.data(), i, 0, compare);
+	}
+}
+
+// Helper for heap sort (max-heap)
+template <typename T, typename Compare, size_t Arity>
+void DaryHeap<T, Compare, Arity>::heapifyDownForSort(T* arr, size_t n, size_t i, Compare& compare) {
+	T value = std::move(arr[i]);
+
+	for (;;) {
+		size_t first = firstChild(i);
+		if (first >= n) break;
+
+		size_t largest = first;
+		size_t last = first + Arity <= n ? first + Arity : n;
+		for (size_t child = first + 1; child < last; child++) {
+			if (compare(arr[largest], arr[child])) largest = child;
+		}
+
+		if (!compare(value, arr[largest])) break;
+		arr[i] = std::move(arr[largest]);
+		i = largest;
+	}
+	arr[i] = std::move(value);
+}
+
+// Instantiated once in heap.cpp; other translation units link to it
+extern template class DaryHeap<int>;
+
 #endif
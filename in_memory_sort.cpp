@@ -0,0 +1,198 @@
+#include "in_memory_sort.h"
+#include "input_sample.h"
+#include "mapped_input.h"
+#include "sort_strategy.h"
+#include "natural_runs.h"
+#include "loser_tree.h"
+#include "int_writer.h"
+#include "file_io.h"
+#include "utils.h"
+#include <iostream>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <exception>
+#include <cstdint>
+
+//Shortest text a value can take: one digit and a newline
+static const uint64_t MIN_BYTES_PER_VALUE = 2;
+
+//Headroom over the sampled count for sampling error
+static const uint64_t ESTIMATE_MARGIN_DIVISOR = 8;
+
+//Constructor
+InMemorySorter::InMemorySorter(const std::string& input, const std::string& output, const SortOptions& opts)
+	: inputFilename(input), outputFilename(output), options(opts) {
+	if (options.threadCount < 1) options.threadCount = 1;
+}
+
+uint64_t InMemorySorter::memoryNeeded(uint64_t integers, const SortOptions& options) {
+	size_t threads = static_cast<size_t>(std::max(options.threadCount, 1));
+
+	//Every range is sorted on its own, so scratch adds up to the input
+	uint64_t scratch = sortScratchInts(options.chunkSort, static_cast<size_t>(integers));
+	if (options.adaptiveChunks) scratch = std::max<uint64_t>(scratch, integers / 2);
+
+	uint64_t buffers = options.asyncOutput ? MemoryGovernor::ASYNC_WRITER_BYTES : MemoryGovernor::INT_WRITER_BYTES;
+	if (options.inputMode == InputMode::Stream) {
+		buffers += threads * MemoryGovernor::PARSE_BUFFER_BYTES;
+	}
+	return (integers + scratch) * sizeof(int) + buffers;
+}
+
+bool InMemorySorter::fits(size_t memoryBudget) {
+	uint64_t fileBytes = FileIO::getFileSize(inputFilename);
+
+	//Too big even at the longest text per value ("-2147483648\n")
+	if (fileBytes / 12 * sizeof(int) > memoryBudget) return false;
+
+	//Sampled count plus headroom, but never more than the file could hold
+	InputSample sample = sampleInput(inputFilename);
+	uint64_t estimate = sample.estimateCount();
+	estimate += estimate / ESTIMATE_MARGIN_DIVISOR;
+	uint64_t upperBound = (fileBytes + MIN_BYTES_PER_VALUE - 1) / MIN_BYTES_PER_VALUE;
+	stats.estimatedIntegers = std::min(estimate, upperBound);
+	return memoryNeeded(stats.estimatedIntegers, options) <= memoryBudget;
+}
+
+//Each thread parses one byte range into its own array and sorts it
+void InMemorySorter::parseAndSort(std::vector<std::vector<int>>& ranges, std::vector<MemoryReservation>& rangeMemory) {
+	std::vector<ByteRange> byteRanges = FileIO::splitAtNewlines(inputFilename, static_cast<size_t>(options.threadCount));
+	uint64_t fileBytes = std::max<uint64_t>(FileIO::getFileSize(inputFilename), 1);
+	ranges.assign(byteRanges.size(), std::vector<int>());
+	rangeMemory.resize(byteRanges.size());
+	stats.threads = byteRanges.size();
+
+	std::mutex mutex;
+	std::exception_ptr error;
+	std::vector<std::thread> workers;
+	for (size_t r = 0; r < byteRanges.size(); r++) {
+		workers.emplace_back([&, r]() {
+			try {
+				const ByteRange& range = byteRanges[r];
+				std::vector<int>& data = ranges[r];
+
+				//Room for this range's share of the estimate, so the
+				//array is not regrown while parsing
+				size_t expected = static_cast<size_t>(stats.estimatedIntegers * range.length / fileBytes) + 1024;
+				rangeMemory[r] = MemoryReservation(options.memory, expected * sizeof(int));
+				data.reserve(expected);
+				{
+					std::unique_ptr<IntParser> input = openIntInput(inputFilename, options.inputMode, range);
+					MemoryReservation parseMemory(options.memory,
+						options.inputMode == InputMode::Stream ? MemoryGovernor::PARSE_BUFFER_BYTES : 0);
+					input->fill(data, SIZE_MAX);
+				}
+				rangeMemory[r].reset(data.capacity() * sizeof(int));
+
+				Timer sortTimer;
+				size_t skipped = 0;
+				NaturalOrder order = NaturalOrder::Unsorted;
+				if (options.adaptiveChunks) {
+					//Counted before the sort grows it (up to half the range, as in
+					//memoryNeeded), for as long as it exists
+					std::vector<int> scratch;
+					MemoryReservation scratchMemory(options.memory, data.size() / 2 * sizeof(int));
+					size_t runs;
+					order = NaturalRunSort::sort(data, scratch, runs);
+					scratchMemory.reset(std::max(scratch.capacity(), data.size() / 2) * sizeof(int));
+				}
+				if (order == NaturalOrder::Unsorted) {
+					std::unique_ptr<ChunkSortStrategy> sorter = makeSortStrategy(options.chunkSort);
+					MemoryReservation scratchMemory(options.memory,
+						sortScratchInts(options.chunkSort, data.size()) * sizeof(int));
+					sorter->sort(data);
+				}
+				else {
+					skipped = data.size();
+				}
+				double sortSeconds = sortTimer.elapsed();
+
+				std::lock_guard<std::mutex> lock(mutex);
+				stats.totalIntegers += data.size();
+				stats.integersSkipped += skipped;
+				stats.sortSeconds += sortSeconds;
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock(mutex);
+				if (!error) error = std::current_exception();
+			}
+		});
+	}
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
+
+//K-way merge of the sorted ranges into the output
+template <typename Writer>
+size_t InMemorySorter::mergeRanges(const std::vector<std::vector<int>>& ranges, Writer& output) {
+	if (ranges.size() == 1) {
+		for (int value : ranges[0]) output.write(value);
+		return ranges[0].size();
+	}
+
+	std::vector<size_t> cursors(ranges.size(), 0);
+	LoserTree tree(ranges.size());
+	for (size_t r = 0; r < ranges.size(); r++) {
+		if (!ranges[r].empty()) {
+			tree.setSource(static_cast<int>(r), ranges[r][0]);
+			cursors[r] = 1;
+		}
+	}
+	tree.build();
+
+	size_t written = 0;
+	while (!tree.isEmpty()) {
+		int r = tree.winner();
+		output.write(tree.winnerKey());
+		written++;
+		if (cursors[r] < ranges[r].size()) {
+			tree.replaceWinner(ranges[r][cursors[r]++]);
+		}
+		else {
+			tree.exhaustWinner();
+		}
+	}
+	return written;
+}
+
+//Main operation
+void InMemorySorter::sort() {
+	uint64_t estimate = stats.estimatedIntegers;
+	stats = InMemoryStats();
+	stats.estimatedIntegers = estimate;
+
+	std::cout << " Input fits in memory: about " << estimate << " integers, "
+		<< options.threadCount << " thread(s), " << sortAlgorithmName(options.chunkSort) << "\n";
+
+	Timer parseTimer;
+	std::vector<std::vector<int>> ranges;
+	std::vector<MemoryReservation> rangeMemory;
+	parseAndSort(ranges, rangeMemory);
+	stats.parseSeconds = parseTimer.elapsed();
+	std::cout << " Parsed and sorted " << stats.totalIntegers << " integers in " << ranges.size()
+		<< " range(s): " << formatTime(stats.parseSeconds) << "\n";
+
+	Timer writeTimer;
+	if (options.asyncOutput) {
+		MemoryReservation outputMemory(options.memory, MemoryGovernor::ASYNC_WRITER_BYTES);
+		AsyncIntWriter output(outputFilename, options.syncOutput);
+		mergeRanges(ranges, output);
+		output.close();
+	}
+	else {
+		MemoryReservation outputMemory(options.memory, MemoryGovernor::INT_WRITER_BYTES);
+		IntWriter output(outputFilename);
+		mergeRanges(ranges, output);
+		if (options.syncOutput) {
+			output.sync();
+		}
+		output.close();
+	}
+	stats.writeSeconds = writeTimer.elapsed();
+	std::cout << " Wrote " << outputFilename << ": " << formatTime(stats.writeSeconds) << "\n";
+}
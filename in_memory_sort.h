@@ -0,0 +1,62 @@
+#pragma once
+#ifndef IN_MEMORY_SORT_H
+#define IN_MEMORY_SORT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "sort_options.h"
+#include "memory_governor.h"
+
+// Statistics of the last InMemorySorter::sort() call
+struct InMemoryStats {
+	uint64_t estimatedIntegers = 0;  // From a sample, with headroom
+	size_t totalIntegers = 0;
+	size_t threads = 0;
+	size_t integersSkipped = 0;      // In presorted ranges (natural run detection)
+	double parseSeconds = 0;         // Parsing and sorting the ranges
+	double sortSeconds = 0;          // Of which sorting, summed over threads
+	double writeSeconds = 0;         // Merging the sorted ranges into the output
+};
+
+// InMemorySorter: sort an input that fits in memory without temp files.
+//
+// Threads parse newline-aligned byte ranges of the input into their own
+// arrays and sort them with the chunk sort kernel; a loser tree then
+// merges the sorted ranges straight into the output file. The input is
+// read once and the output written once, instead of also writing and
+// reading back a run file.
+class InMemorySorter {
+private:
+	std::string inputFilename;
+	std::string outputFilename;
+	SortOptions options;
+	InMemoryStats stats;
+
+	//Helper functions
+	void parseAndSort(std::vector<std::vector<int>>& ranges, std::vector<MemoryReservation>& rangeMemory);
+	template <typename Writer>
+	size_t mergeRanges(const std::vector<std::vector<int>>& ranges, Writer& output);
+
+public:
+	//Constructor
+	InMemorySorter(const std::string& input, const std::string& output,
+		const SortOptions& options = SortOptions());
+
+	// Bytes sorting `integers` values in memory takes with these options:
+	// the arrays, the kernel's scratch and the reader/writer buffers
+	static uint64_t memoryNeeded(uint64_t integers, const SortOptions& options);
+
+	// Whether the input fits memoryBudget, from a sampled estimate of the
+	// count with some headroom (capped by the file size at 2 bytes per
+	// value). Sets stats.estimatedIntegers.
+	bool fits(size_t memoryBudget);
+
+	// Sort the input into the output file
+	void sort();
+
+	//Getters
+	const InMemoryStats& getStats() const { return stats; }
+};
+
+#endif
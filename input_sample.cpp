@@ -0,0 +1,33 @@
+#include "input_sample.h"
+#include "int_parser.h"
+#include "file_io.h"
+
+//Small reads: a window is only a few KB of text
+static const size_t SAMPLE_BLOCK = 64 * 1024;
+
+uint64_t InputSample::estimateCount() const {
+	if (values.empty() || sampledBytes == 0) return 0;
+	double bytesPerValue = static_cast<double>(sampledBytes) / values.size();
+	return static_cast<uint64_t>(fileBytes / bytesPerValue + 0.5);
+}
+
+InputSample sampleInput(const std::string& filename, size_t windows, size_t valuesPerWindow) {
+	InputSample sample;
+	sample.fileBytes = FileIO::getFileSize(filename);
+
+	//Line-aligned window starts, spread over the whole file
+	std::vector<ByteRange> ranges = FileIO::splitAtNewlines(filename, windows);
+	sample.values.reserve(ranges.size() * valuesPerWindow);
+	for (const ByteRange& range : ranges) {
+		std::unique_ptr<BlockSource> source(new FileBlockSource(filename, SAMPLE_BLOCK, range.offset, range.length));
+		IntParser parser(std::move(source), filename, range.offset);
+		sample.windowStarts.push_back(sample.values.size());
+
+		int value;
+		for (size_t i = 0; i < valuesPerWindow && parser.next(value); i++) {
+			sample.values.push_back(value);
+		}
+		sample.sampledBytes += parser.getOffset() - range.offset;
+	}
+	return sample;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#ifndef INPUT_SAMPLE_H
+#define INPUT_SAMPLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Values read from evenly spaced windows of a text input file, without
+// parsing the whole file. Each window starts on a line boundary and is
+// read in file order.
+struct InputSample {
+	std::vector<int> values;       // Window after window, in file order
+	std::vector<size_t> windowStarts;   // Index in values where each window begins
+	uint64_t fileBytes = 0;
+	uint64_t sampledBytes = 0;     // Text consumed to read the values
+
+	// Element count extrapolated from the bytes per sampled value
+	uint64_t estimateCount() const;
+};
+
+// Read up to valuesPerWindow values from each of `windows` places in the
+// file (throws if the file cannot be read or a sampled token is malformed)
+InputSample sampleInput(const std::string& filename, size_t windows = 64, size_t valuesPerWindow = 1024);
+
+#endif
@@ -0,0 +1,233 @@
+#include "int_parser.h"
+#include "file_io.h"
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define INT_PARSER_SSE2 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace {
+
+inline bool isSpace(char c) {
+	return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+}
+
+inline bool isDigit(char c) {
+	return static_cast<unsigned char>(c - '0') < 10;
+}
+
+#ifdef INT_PARSER_SSE2
+inline unsigned countTrailingZeros(unsigned mask) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return static_cast<unsigned>(index);
+#else
+	return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+#endif
+
+// Length of the digit run at p (p may not be dereferenced at limit)
+inline size_t digitRun(const char* p, const char* limit) {
+#ifdef INT_PARSER_SSE2
+	//16 digits at once: anything shorter is found with a single compare
+	if (limit - p >= 16) {
+		__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		__m128i shifted = _mm_sub_epi8(bytes, _mm_set1_epi8('0'));
+		__m128i digits = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(9)), shifted);
+		unsigned nonDigit = ~static_cast<unsigned>(_mm_movemask_epi8(digits)) & 0xFFFFu;
+		if (nonDigit != 0) {
+			return countTrailingZeros(nonDigit);
+		}
+	}
+#endif
+	size_t len = 0;
+	while (p + len < limit && isDigit(p[len])) len++;
+	return len;
+}
+
+// Parse one token starting at p. Returns the position past the token,
+// or nullptr if the token is not a valid int.
+const char* parseToken(const char* p, const char* limit, int& value) {
+	bool negative = false;
+	if (p < limit && (*p == '-' || *p == '+')) {
+		negative = (*p == '-');
+		p++;
+	}
+
+	size_t len = digitRun(p, limit);
+	if (len == 0) return nullptr;
+
+	const char* after = p + len;
+	if (after < limit && !isSpace(*after)) return nullptr;
+
+	//Leading zeros do not count towards the overflow cap
+	while (p + 1 < after && *p == '0') p++;
+	if (after - p > 18) return nullptr;
+
+	uint64_t acc = 0;
+	for (; p < after; p++) {
+		acc = acc * 10 + static_cast<uint64_t>(*p - '0');
+	}
+
+	if (negative) {
+		if (acc > 2147483648ULL) return nullptr;
+		value = static_cast<int>(-static_cast<int64_t>(acc));
+	}
+	else {
+		if (acc > 2147483647ULL) return nullptr;
+		value = static_cast<int>(acc);
+	}
+	return after;
+}
+
+// Longest token we are willing to carry across a block boundary
+const size_t MAX_TOKEN = 64;
+
+// Bytes needed ahead of a token for the in-block fast path
+const ptrdiff_t FAST_PATH_WINDOW = 32;
+
+}
+
+// ---------------- FileBlockSource ----------------
+
+FileBlockSource::FileBlockSource(const std::string& filename, size_t blockSize,
+	uint64_t offset, uint64_t length)
+	: file(nullptr), buffer(blockSize > 0 ? blockSize : 1), remaining(length) {
+	file = std::fopen(filename.c_str(), "rb");
+	if (!file) {
+		throw std::runtime_error("Cannot open input file: " + filename);
+	}
+	if (offset > 0 && !FileIO::seek(file, offset)) {
+		std::fclose(file);
+		throw std::runtime_error("Cannot seek input file: " + filename);
+	}
+}
+
+FileBlockSource::~FileBlockSource() {
+	if (file) std::fclose(file);
+}
+
+size_t FileBlockSource::nextBlock(const char*& data) {
+	size_t want = static_cast<size_t>(std::min<uint64_t>(buffer.size(), remaining));
+	size_t got = want > 0 ? std::fread(buffer.data(), 1, want, file) : 0;
+	remaining -= got;
+	data = buffer.data();
+	return got;
+}
+
+// ---------------- IntParser ----------------
+
+IntParser::IntParser(const std::string& filename, size_t blockSize)
+	: IntParser(std::unique_ptr<BlockSource>(new FileBlockSource(filename, blockSize)), filename) {
+}
+
+IntParser::IntParser(std::unique_ptr<BlockSource> src, const std::string& name, uint64_t startOffset)
+	: source(std::move(src)), sourceName(name), blockBegin(nullptr), cur(nullptr), end(nullptr),
+	blockOffset(startOffset), line(1), lineKnown(startOffset == 0), exhausted(false) {
+}
+
+bool IntParser::refill() {
+	if (exhausted) return false;
+
+	blockOffset += static_cast<uint64_t>(end - blockBegin);
+
+	const char* data = nullptr;
+	size_t size = source->nextBlock(data);
+	if (size == 0) {
+		exhausted = true;
+		blockBegin = cur = end = nullptr;
+		return false;
+	}
+
+	blockBegin = cur = data;
+	end = data + size;
+	return true;
+}
+
+uint64_t IntParser::getOffset() const {
+	return blockOffset + static_cast<uint64_t>(cur - blockBegin);
+}
+
+void IntParser::fail(uint64_t offset, const std::string& token) const {
+	std::string where = lineKnown ? " (line " + std::to_string(line) + ")" : "";
+	throw ParseError("Malformed integer '" + token + "' at byte offset " + std::to_string(offset)
+		+ where + " in " + sourceName, offset, lineKnown ? line : 0);
+}
+
+bool IntParser::next(int& value) {
+	//Skip whitespace, counting lines for error reports
+	for (;;) {
+		while (cur < end && isSpace(*cur)) {
+			if (*cur == '\n') line++;
+			cur++;
+		}
+		if (cur < end) break;
+		if (!refill()) return false;
+	}
+
+	//Fast path: the token and its delimiter are inside this block. A
+	//token running up to the block end may continue in the next one.
+	if (end - cur >= FAST_PATH_WINDOW) {
+		const char* after = parseToken(cur, end, value);
+		if (after && after < end) {
+			cur = after;
+			return true;
+		}
+		if (!after) {
+			const char* stop = cur;
+			while (stop < end && !isSpace(*stop)) stop++;
+			if (stop < end) {
+				fail(getOffset(), std::string(cur, std::min(stop, cur + MAX_TOKEN)));
+			}
+		}
+	}
+
+	return nextSlow(value);
+}
+
+// Token may straddle a block boundary: gather it into a small carry buffer
+bool IntParser::nextSlow(int& value) {
+	uint64_t tokenOffset = getOffset();
+	char carry[MAX_TOKEN];
+	size_t length = 0;
+
+	for (;;) {
+		while (cur < end && !isSpace(*cur)) {
+			//A leading zero followed by another digit is dropped, so
+			//zero padding of any length fits the carry buffer
+			size_t digits = length > 0 && (carry[0] == '-' || carry[0] == '+') ? 1 : 0;
+			if (length == digits + 1 && carry[digits] == '0' && isDigit(*cur)) {
+				carry[digits] = *cur++;
+				continue;
+			}
+			if (length == MAX_TOKEN) {
+				fail(tokenOffset, std::string(carry, length) + "...");
+			}
+			carry[length++] = *cur++;
+		}
+		if (cur < end || !refill()) break;
+	}
+
+	const char* after = parseToken(carry, carry + length, value);
+	if (after != carry + length) {
+		fail(tokenOffset, std::string(carry, length));
+	}
+	return true;
+}
+
+size_t IntParser::fill(std::vector<int>& out, size_t maxCount) {
+	size_t added = 0;
+	int value;
+
+	while (out.size() < maxCount && next(value)) {
+		out.push_back(value);
+		added++;
+	}
+	return added;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#ifndef INT_PARSER_H
+#define INT_PARSER_H
+
+#include <cstdio>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Source of raw input bytes, handed out in large blocks.
+class BlockSource {
+public:
+	virtual ~BlockSource() {}
+
+	// Point data at the next block and return its size (0 = end of input).
+	// The block stays valid until the next call.
+	virtual size_t nextBlock(const char*& data) = 0;
+};
+
+// Reads a file (or a byte range of it) through one large reusable buffer.
+class FileBlockSource : public BlockSource {
+private:
+	std::FILE* file;
+	std::vector<char> buffer;
+	uint64_t remaining;
+
+public:
+	explicit FileBlockSource(const std::string& filename, size_t blockSize = 4 * 1024 * 1024,
+		uint64_t offset = 0, uint64_t length = UINT64_MAX);
+	~FileBlockSource();
+
+	FileBlockSource(const FileBlockSource&) = delete;
+	FileBlockSource& operator=(const FileBlockSource&) = delete;
+
+	size_t nextBlock(const char*& data) override;
+};
+
+// Thrown for malformed or out-of-range tokens
+class ParseError : public std::runtime_error {
+private:
+	uint64_t offset;
+	uint64_t line;
+
+public:
+	ParseError(const std::string& message, uint64_t offset, uint64_t line)
+		: std::runtime_error(message), offset(offset), line(line) {}
+
+	uint64_t getOffset() const { return offset; }   // Byte offset of the bad token
+	uint64_t getLine() const { return line; }       // 1-based line number (0 = unknown)
+};
+
+// High-throughput parser for whitespace-separated decimal integers.
+// Replaces `istream >> int`: no locale, no per-value virtual calls, and
+// an SSE2 digit scan on x86 when the token is not near a block edge.
+class IntParser {
+private:
+	std::unique_ptr<BlockSource> source;
+	std::string sourceName;
+
+	const char* blockBegin;
+	const char* cur;
+	const char* end;
+	uint64_t blockOffset;   // Byte offset of the current block start
+	uint64_t line;
+	bool lineKnown;         // False when parsing a range that starts mid-file
+	bool exhausted;
+
+	bool refill();
+	bool nextSlow(int& value);
+	[[noreturn]] void fail(uint64_t offset, const std::string& token) const;
+
+public:
+	explicit IntParser(const std::string& filename, size_t blockSize = 4 * 1024 * 1024);
+	// startOffset: file offset of the source's first byte, for error reports
+	IntParser(std::unique_ptr<BlockSource> source, const std::string& name, uint64_t startOffset = 0);
+
+	// Read next integer; returns false at end of input
+	bool next(int& value);
+
+	// Append values to out until it holds maxCount elements or input ends.
+	// Never grows out beyond maxCount, so a reserved vector is reused as-is.
+	size_t fill(std::vector<int>& out, size_t maxCount);
+
+	// Bytes consumed so far
+	uint64_t getOffset() const;
+};
+
+#endif
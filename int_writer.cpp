@@ -0,0 +1,204 @@
+#include "int_writer.h"
+#include "file_io.h"
+#include "utils.h"
+#include <stdexcept>
+
+const char DIGIT_PAIRS[200] = {
+	'0','0','0','1','0','2','0','3','0','4','0','5','0','6','0','7','0','8','0','9',
+	'1','0','1','1','1','2','1','3','1','4','1','5','1','6','1','7','1','8','1','9',
+	'2','0','2','1','2','2','2','3','2','4','2','5','2','6','2','7','2','8','2','9',
+	'3','0','3','1','3','2','3','3','3','4','3','5','3','6','3','7','3','8','3','9',
+	'4','0','4','1','4','2','4','3','4','4','4','5','4','6','4','7','4','8','4','9',
+	'5','0','5','1','5','2','5','3','5','4','5','5','5','6','5','7','5','8','5','9',
+	'6','0','6','1','6','2','6','3','6','4','6','5','6','6','6','7','6','8','6','9',
+	'7','0','7','1','7','2','7','3','7','4','7','5','7','6','7','7','7','8','7','9',
+	'8','0','8','1','8','2','8','3','8','4','8','5','8','6','8','7','8','8','8','9',
+	'9','0','9','1','9','2','9','3','9','4','9','5','9','6','9','7','9','8','9','9'
+};
+
+IntWriter::IntWriter(const std::string& name, size_t bufferSize)
+	: file(nullptr), filename(name), buffer(bufferSize > MAX_INT_TEXT ? bufferSize : MAX_INT_TEXT),
+	used(0), bytesWritten(0) {
+	file = std::fopen(filename.c_str(), "wb");
+	if (!file) {
+		throw std::runtime_error("Cannot create output file: " + filename);
+	}
+
+	//Our buffer is the only buffer: one write call per flush
+	std::setvbuf(file, nullptr, _IONBF, 0);
+}
+
+IntWriter::~IntWriter() {
+	if (file) {
+		try {
+			close();
+		}
+		catch (...) {
+			//Never throw from destructor
+		}
+	}
+}
+
+void IntWriter::flushBuffer() {
+	if (used == 0) return;
+	if (std::fwrite(buffer.data(), 1, used, file) != used) {
+		throw std::runtime_error("Failed writing output file: " + filename);
+	}
+	bytesWritten += used;
+	used = 0;
+}
+
+void IntWriter::write(const int* values, size_t count) {
+	for (size_t i = 0; i < count; i++) {
+		if (buffer.size() - used < MAX_INT_TEXT) flushBuffer();
+		used += formatInt(values[i], buffer.data() + used);
+	}
+}
+
+void IntWriter::writeRepeated(int value, uint64_t count) {
+	char text[MAX_INT_TEXT];
+	size_t length = formatInt(value, text);
+	for (; count > 0; count--) {
+		if (buffer.size() - used < MAX_INT_TEXT) flushBuffer();
+		std::memcpy(buffer.data() + used, text, length);
+		used += length;
+	}
+}
+
+void IntWriter::append(const std::string& textFile) {
+	flushBuffer();
+	std::FILE* in = std::fopen(textFile.c_str(), "rb");
+	if (!in) {
+		throw std::runtime_error("Cannot open file: " + textFile);
+	}
+
+	//The format buffer is free after the flush: copy through it
+	size_t got;
+	while ((got = std::fread(buffer.data(), 1, buffer.size(), in)) > 0) {
+		if (std::fwrite(buffer.data(), 1, got, file) != got) {
+			std::fclose(in);
+			throw std::runtime_error("Failed writing output file: " + filename);
+		}
+		bytesWritten += got;
+	}
+	bool failed = std::ferror(in) != 0;
+	std::fclose(in);
+	if (failed) {
+		throw std::runtime_error("Failed reading file: " + textFile);
+	}
+}
+
+void IntWriter::sync() {
+	if (!file) return;
+	flushBuffer();
+	if (!FileIO::syncData(file)) {
+		throw std::runtime_error("Failed syncing output file: " + filename);
+	}
+}
+
+void IntWriter::close() {
+	if (!file) return;
+
+	std::FILE* f = file;
+	try {
+		flushBuffer();
+	}
+	catch (...) {
+		file = nullptr;
+		std::fclose(f);
+		throw;
+	}
+
+	file = nullptr;
+	if (std::fclose(f) != 0) {
+		throw std::runtime_error("Failed closing output file: " + filename);
+	}
+}
+
+// ---------------- AsyncIntWriter ----------------
+
+AsyncIntWriter::AsyncIntWriter(const std::string& filename, bool sync, size_t bufferInts, size_t bufferCount)
+	: writer(filename), syncOnClose(sync), buffers(bufferCount > 1 ? bufferCount : 2),
+	freeBuffers(buffers.size()), jobs(buffers.size()), closed(false),
+	waitSeconds(0), syncSeconds(0) {
+	for (auto& buffer : buffers) {
+		buffer.resize(bufferInts > 0 ? bufferInts : 1);
+	}
+	for (size_t i = 1; i < buffers.size(); i++) {
+		freeBuffers.push(&buffers[i]);
+	}
+	current = &buffers[0];
+	cursor = current->data();
+	limit = cursor + current->size();
+
+	thread = std::thread(&AsyncIntWriter::writerLoop, this);
+}
+
+AsyncIntWriter::~AsyncIntWriter() {
+	try {
+		finish();
+	}
+	catch (...) {
+		//Never throw from destructor
+	}
+}
+
+//Writer thread: format and write full buffers, then hand them back
+void AsyncIntWriter::writerLoop() {
+	Job job;
+	while (jobs.pop(job)) {
+		try {
+			if (!error) writer.write(job.buffer->data(), job.count);
+		}
+		catch (...) {
+			error = std::current_exception();
+		}
+		freeBuffers.push(job.buffer);
+	}
+}
+
+//Current buffer is full: queue it and continue in a free one
+void AsyncIntWriter::swapBuffer() {
+	jobs.push(Job{ current, static_cast<size_t>(cursor - current->data()) });
+
+	Timer timer;
+	freeBuffers.pop(current);
+	waitSeconds += timer.elapsed();
+
+	cursor = current->data();
+	limit = cursor + current->size();
+}
+
+//Queue the partial buffer and stop the writer thread
+void AsyncIntWriter::finish() {
+	if (closed) return;
+	closed = true;
+
+	size_t count = static_cast<size_t>(cursor - current->data());
+	if (count > 0) {
+		jobs.push(Job{ current, count });
+	}
+	jobs.close();
+	thread.join();
+}
+
+void AsyncIntWriter::close() {
+	finish();
+
+	//The writer thread has exited, so error and writer are ours now
+	if (error) {
+		try {
+			writer.close();
+		}
+		catch (...) {
+			//Report the first failure
+		}
+		std::rethrow_exception(error);
+	}
+	if (syncOnClose) {
+		Timer timer;
+		writer.sync();
+		syncSeconds = timer.elapsed();
+	}
+	writer.close();
+}
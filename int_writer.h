@@ -0,0 +1,142 @@
+#pragma once
+#ifndef INT_WRITER_H
+#define INT_WRITER_H
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <thread>
+#include <exception>
+#include "bounded_queue.h"
+
+// "00".."99" packed, used to emit two digits per lookup
+extern const char DIGIT_PAIRS[200];
+
+// Longest formatted int plus newline: "-2147483648\n"
+const size_t MAX_INT_TEXT = 12;
+
+// Format value followed by '\n' at out; returns number of bytes written.
+// out must have room for MAX_INT_TEXT bytes.
+inline size_t formatInt(int value, char* out) {
+	char temp[MAX_INT_TEXT];
+	char* p = temp + MAX_INT_TEXT;
+	*--p = '\n';
+
+	uint32_t u = value < 0 ? 0u - static_cast<uint32_t>(value) : static_cast<uint32_t>(value);
+	while (u >= 100) {
+		uint32_t pair = (u % 100) * 2;
+		u /= 100;
+		p -= 2;
+		p[0] = DIGIT_PAIRS[pair];
+		p[1] = DIGIT_PAIRS[pair + 1];
+	}
+	if (u >= 10) {
+		p -= 2;
+		p[0] = DIGIT_PAIRS[u * 2];
+		p[1] = DIGIT_PAIRS[u * 2 + 1];
+	}
+	else {
+		*--p = static_cast<char>('0' + u);
+	}
+	if (value < 0) *--p = '-';
+
+	size_t length = static_cast<size_t>(temp + MAX_INT_TEXT - p);
+	std::memcpy(out, p, length);
+	return length;
+}
+
+// Text writer for the user-facing output: one integer per line, formatted
+// into a large reusable buffer that is written out with one call per block.
+class IntWriter {
+private:
+	std::FILE* file;
+	std::string filename;
+	std::vector<char> buffer;
+	size_t used;
+	uint64_t bytesWritten;
+
+	void flushBuffer();
+
+public:
+	explicit IntWriter(const std::string& filename, size_t bufferSize = 1024 * 1024);
+	~IntWriter();
+
+	IntWriter(const IntWriter&) = delete;
+	IntWriter& operator=(const IntWriter&) = delete;
+
+	void write(int value) {
+		if (buffer.size() - used < MAX_INT_TEXT) flushBuffer();
+		used += formatInt(value, buffer.data() + used);
+	}
+
+	void write(const int* values, size_t count);
+
+	// Write count copies of value, formatting it only once
+	void writeRepeated(int value, uint64_t count);
+
+	// Copy an already formatted text file to the output, after what is buffered
+	void append(const std::string& textFile);
+
+	// Write out everything buffered and fdatasync the file
+	void sync();
+	void close();
+
+	uint64_t getBytesWritten() const { return bytesWritten + used; }
+};
+
+// Double-buffered IntWriter: the caller only copies raw ints into the
+// current buffer; a writer thread formats and writes full buffers while
+// the next one fills. With bufferCount buffers, up to bufferCount - 1
+// can be queued before write() has to wait for the disk.
+class AsyncIntWriter {
+private:
+	struct Job {
+		std::vector<int>* buffer;
+		size_t count;
+	};
+
+	IntWriter writer;
+	bool syncOnClose;
+	std::vector<std::vector<int>> buffers;
+	BoundedQueue<std::vector<int>*> freeBuffers;
+	BoundedQueue<Job> jobs;
+	std::thread thread;
+	std::exception_ptr error;
+	bool closed;
+
+	std::vector<int>* current;
+	int* cursor;
+	int* limit;
+	double waitSeconds;
+	double syncSeconds;
+
+	void writerLoop();
+	void swapBuffer();
+	void finish();
+
+public:
+	// syncOnClose: fdatasync the output before close() returns
+	explicit AsyncIntWriter(const std::string& filename, bool syncOnClose = false,
+		size_t bufferInts = 256 * 1024, size_t bufferCount = 2);
+	~AsyncIntWriter();
+
+	AsyncIntWriter(const AsyncIntWriter&) = delete;
+	AsyncIntWriter& operator=(const AsyncIntWriter&) = delete;
+
+	void write(int value) {
+		if (cursor == limit) swapBuffer();
+		*cursor++ = value;
+	}
+
+	// Drain the buffers, join the writer, optionally sync, then close.
+	// Rethrows the first write error.
+	void close();
+
+	uint64_t getBytesWritten() const { return writer.getBytesWritten(); }   // Valid after close()
+	double getWaitSeconds() const { return waitSeconds; }   // Caller blocked on a full pipeline
+	double getSyncSeconds() const { return syncSeconds; }
+};
+
+#endif
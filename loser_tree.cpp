@@ -0,0 +1,25 @@
+#include "loser_tree.h"
+
+LoserTree::LoserTree(size_t sources) {
+	reset(sources);
+}
+
+void LoserTree::reset(size_t sources) {
+	sourceCount = sources;
+	losers.assign(2 * sources, EXHAUSTED);
+	winnerNode = EXHAUSTED;
+}
+
+void LoserTree::build() {
+	if (sourceCount == 0) return;
+
+	//Winners of each match, bottom-up; leaves are their own winners
+	std::vector<uint64_t> winners(losers);
+	for (size_t node = sourceCount - 1; node > 0; node--) {
+		uint64_t left = winners[2 * node];
+		uint64_t right = winners[2 * node + 1];
+		losers[node] = left < right ? right : left;
+		winners[node] = left < right ? left : right;
+	}
+	winnerNode = winners[1];
+}
@@ -0,0 +1,73 @@
+#pragma once
+#ifndef LOSER_TREE_H
+#define LOSER_TREE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Tournament (loser) tree for merging K sorted int sources.
+//
+// Each internal node keeps the loser of the match played there. After the
+// winner's source advances, only the path from its leaf to the root is
+// replayed: log K comparisons per output element, and no element is moved
+// around as in a heap.
+//
+// A node packs the key (offset to unsigned) above the source index in one
+// 64-bit word, so each match is a single integer compare against the
+// cached key, ties go to the lower source, and the replay compiles to
+// branch-free min/max. Exhausted sources hold an all-ones sentinel that
+// is above every packed key, so they lose every match without a separate
+// check; the merge is over when the sentinel wins.
+class LoserTree {
+private:
+	static constexpr uint64_t EXHAUSTED = UINT64_MAX;
+
+	static uint64_t pack(int key, int source) {
+		return (static_cast<uint64_t>(static_cast<uint32_t>(key) ^ 0x80000000u) << 32)
+			| static_cast<uint32_t>(source);
+	}
+
+	size_t sourceCount;
+	std::vector<uint64_t> losers;   // losers[1..K-1]; leaf s sits at position K + s
+	uint64_t winnerNode;
+
+	// Play the winner back up from its leaf with a new packed key
+	void replay(uint64_t current) {
+		size_t node = (sourceCount + winner()) / 2;
+		for (; node > 0; node /= 2) {
+			uint64_t loser = losers[node];
+			losers[node] = loser < current ? current : loser;
+			current = loser < current ? loser : current;
+		}
+		winnerNode = current;
+	}
+
+public:
+	explicit LoserTree(size_t sources = 0);
+
+	// Start a merge of `sources` sources (drops any previous state)
+	void reset(size_t sources);
+
+	// Initial key of a source (before build); sources never set are exhausted
+	void setSource(int source, int key) { losers[sourceCount + source] = pack(key, source); }
+
+	// Play all matches once the initial keys are set
+	void build();
+
+	bool isEmpty() const { return winnerNode == EXHAUSTED; }
+
+	// Source holding the current minimum and its key
+	int winner() const { return static_cast<int>(static_cast<uint32_t>(winnerNode)); }
+	int winnerKey() const { return static_cast<int>(static_cast<uint32_t>(winnerNode >> 32) ^ 0x80000000u); }
+
+	// The winner's source produced its next key
+	void replaceWinner(int key) { replay(pack(key, winner())); }
+
+	// The winner's source has no more keys
+	void exhaustWinner() { replay(EXHAUSTED); }
+
+	size_t size() const { return sourceCount; }
+};
+
+#endif
@@ -1,16 +1,244 @@
 #include "sorter.h"
+#include "sort_strategy.h"
 #include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <cerrno>
+#include <cctype>
+#include <climits>
+#include <thread>
 
-int main() {
+void printUsage() {
+    std::cout << "Usage: sorter [input] [output] [chunkMB] [options]\n";
+    std::cout << "  --auto             Choose chunk size, sort kernel, runs and fan-in from a sample\n";
+    std::cout << "  --mode MODE        Whole-file algorithm: merge (default) or distribute\n";
+    std::cout << "  --buckets N        Buckets for --mode distribute (default: half a chunk each)\n";
+    std::cout << "  --no-in-memory     Use temp files even when the input fits in memory\n";
+    std::cout << "  --no-counting      Never use the counting sort for narrow value ranges\n";
+    std::cout << "  --memory MB        Memory for the whole sort; sets chunk size and phase budgets\n";
+    std::cout << "  --threads N        Chunk sorting threads (0 = all cores, default 1)\n";
+    std::cout << "  --chunk-memory MB  Memory for in-flight chunk buffers (default threads+1 chunks)\n";
+    std::cout << "  --runs MODE        Run generation: fixed (default) or replacement\n";
+    std::cout << "  --sort KERNEL      Chunk sort: heap (default), intro, pdq, radix or sample\n";
+    std::cout << "  --no-adaptive      Always run the sort kernel, even on presorted chunks\n";
+    std::cout << "  --compress-runs    Delta + bit-pack the temp run files (less temp I/O)\n";
+    std::cout << "  --temp-dir DIR     Directory for temp files; repeat to spread them over several disks\n";
+    std::cout << "  --temp-placement P Temp directory per file: rr (round-robin, default) or free (most free space)\n";
+    std::cout << "  --huge-pages       Back chunk, scratch and read block buffers with transparent huge pages\n";
+    std::cout << "  --mmap             Parse the input from memory-mapped windows\n";
+    std::cout << "  --merge-memory MB  Memory for merge read blocks (default 64)\n";
+    std::cout << "  --merge-block KB   Read block per run while merging (default: from budget and run count)\n";
+    std::cout << "  --fan-in N         Most runs merged at once (default: from memory and fd limit)\n";
+    std::cout << "  --merge-threads N  Final merge split into N key ranges merged in parallel (0 = all cores)\n";
+    std::cout << "  --no-read-ahead    Read merge blocks on the merge thread only\n";
+    std::cout << "  --no-async-output  Format and write the output on the merge thread\n";
+    std::cout << "  --sync-output      fdatasync the output file before finishing\n";
+    std::cout << "  --splits N         Parse N byte ranges of the input in parallel (0 = all cores)\n";
+}
+
+// Parse a whole non-negative number no larger than max; on anything else
+// report it against its option and return false
+bool parseCount(const std::string& option, const char* text, size_t max, size_t& value) {
+    char* end = nullptr;
+    errno = 0;
+    unsigned long long parsed = std::strtoull(text, &end, 10);
+    if (!std::isdigit(static_cast<unsigned char>(text[0])) || *end != '\0' || errno == ERANGE || parsed > max) {
+        std::cout << "Unknown " << option << " value: " << text << "\n";
+        return false;
+    }
+    value = static_cast<size_t>(parsed);
+    return true;
+}
+
+// Thread counts: 0 means all cores
+bool parseThreads(const std::string& option, const char* text, int& threads) {
+    size_t count;
+    if (!parseCount(option, text, INT_MAX, count)) return false;
+    threads = count > 0 ? static_cast<int>(count) : static_cast<int>(std::thread::hardware_concurrency());
+    return true;
+}
+
+int main(int argc, char* argv[]) {
     // Configuration for 1,000,000 elements test
     std::string inputFile = "input.txt";
     std::string outputFile = "output_sorted.txt";
 
     // Set chunk size to 1MB to ensure multiple chunks are created for demo
     size_t chunkSize = 1024 * 1024;
+    SortOptions options;
+
+    // Command line: positional input/output/chunkMB, then options
+    int positional = 0;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--threads" && hasValue) {
+            if (!parseThreads(arg, argv[++i], options.threadCount)) {
+                printUsage();
+                return 1;
+            }
+        }
+        else if (arg == "--mode" && hasValue) {
+            std::string mode = argv[++i];
+            if (mode == "distribute") {
+                options.sortMode = SortMode::Distribution;
+            }
+            else if (mode == "merge") {
+                options.sortMode = SortMode::MergeRuns;
+            }
+            else {
+                std::cout << "Unknown sort mode: " << mode << "\n";
+                return 1;
+            }
+        }
+        else if (arg == "--auto") {
+            options.autoPlan = true;
+        }
+        else if (arg == "--no-counting") {
+            options.countingSort = false;
+        }
+        else if (arg == "--buckets" && hasValue) {
+            if (!parseCount(arg, argv[++i], SIZE_MAX, options.bucketCount)) {
+                printUsage();
+                return 1;
+            }
+        }
+        else if (arg == "--memory" && hasValue) {
+            size_t size;
+            if (!parseCount(arg, argv[++i], SIZE_MAX / (1024 * 1024), size)) {
+                printUsage();
+                return 1;
+            }
+            options.memoryBudget = size * 1024 * 1024;
+        }
+        else if (arg == "--chunk-memory" && hasValue) {
+            size_t size;
+            if (!parseCount(arg, argv[++i], SIZE_MAX / (1024 * 1024), size)) {
+                printUsage();
+                return 1;
+            }
+            options.chunkMemoryBudget = size * 1024 * 1024;
+        }
+        else if (arg == "--runs" && hasValue) {
+            std::string mode = argv[++i];
+            if (mode == "replacement") {
+                options.runGeneration = RunGeneration::ReplacementSelection;
+            }
+            else if (mode == "fixed") {
+                options.runGeneration = RunGeneration::FixedChunks;
+            }
+            else {
+                std::cout << "Unknown run generation mode: " << mode << "\n";
+                return 1;
+            }
+        }
+        else if (arg == "--sort" && hasValue) {
+            std::string kernel = argv[++i];
+            if (!parseSortAlgorithm(kernel, options.chunkSort)) {
+                std::cout << "Unknown sort kernel: " << kernel << "\n";
+                return 1;
+            }
+        }
+        else if (arg == "--merge-memory" && hasValue) {
+            size_t size;
+            if (!parseCount(arg, argv[++i], SIZE_MAX / (1024 * 1024), size)) {
+                printUsage();
+                return 1;
+            }
+            options.mergeMemoryBudget = size * 1024 * 1024;
+        }
+        else if (arg == "--merge-block" && hasValue) {
+            size_t size;
+            if (!parseCount(arg, argv[++i], SIZE_MAX / 1024, size)) {
+                printUsage();
+                return 1;
+            }
+            options.mergeBlockSize = size * 1024;
+        }
+        else if (arg == "--fan-in" && hasValue) {
+            if (!parseCount(arg, argv[++i], SIZE_MAX, options.maxFanIn)) {
+                printUsage();
+                return 1;
+            }
+        }
+        else if (arg == "--merge-threads" && hasValue) {
+            if (!parseThreads(arg, argv[++i], options.mergeThreads)) {
+                printUsage();
+                return 1;
+            }
+        }
+        else if (arg == "--no-read-ahead") {
+            options.mergeReadAhead = false;
+        }
+        else if (arg == "--no-async-output") {
+            options.asyncOutput = false;
+        }
+        else if (arg == "--sync-output") {
+            options.syncOutput = true;
+        }
+        else if (arg == "--splits" && hasValue) {
+            if (!parseThreads(arg, argv[++i], options.inputSplits)) {
+                printUsage();
+                return 1;
+            }
+        }
+        else if (arg == "--no-in-memory") {
+            options.inMemory = false;
+        }
+        else if (arg == "--temp-dir" && hasValue) {
+            options.tempDirs.push_back(argv[++i]);
+        }
+        else if (arg == "--temp-placement" && hasValue) {
+            std::string placement = argv[++i];
+            if (placement == "free") {
+                options.tempPlacement = TempPlacement::FreeSpace;
+            }
+            else if (placement == "rr") {
+                options.tempPlacement = TempPlacement::RoundRobin;
+            }
+            else {
+                std::cout << "Unknown temp placement: " << placement << "\n";
+                return 1;
+            }
+        }
+        else if (arg == "--huge-pages") {
+            options.hugePages = true;
+        }
+        else if (arg == "--compress-runs") {
+            options.compressRuns = true;
+        }
+        else if (arg == "--no-adaptive") {
+            options.adaptiveChunks = false;
+        }
+        else if (arg == "--mmap") {
+            options.inputMode = InputMode::Mapped;
+        }
+        else if (arg == "--help" || arg == "-h") {
+            printUsage();
+            return 0;
+        }
+        else if (arg.compare(0, 2, "--") == 0) {
+            std::cout << "Unknown option: " << arg << "\n";
+            printUsage();
+            return 1;
+        }
+        else if (positional == 0) { inputFile = arg; positional++; }
+        else if (positional == 1) { outputFile = arg; positional++; }
+        else if (positional == 2) {
+            size_t size;
+            if (!parseCount("chunkMB", argv[i], SIZE_MAX / (1024 * 1024), size)) {
+                printUsage();
+                return 1;
+            }
+            chunkSize = size * 1024 * 1024;
+            positional++;
+        }
+    }
 
     // Initialize the coordinator class
-    Sorter externalSorter(inputFile, outputFile, chunkSize);
+    Sorter externalSorter(inputFile, outputFile, chunkSize, options);
 
     // Run the full process
     externalSorter.run();
@@ -18,4 +246,4 @@ int main() {
     std::cout << "Press Enter to exit...";
     std::cin.get();
     return 0;
-}
\ No newline at end of file
+}
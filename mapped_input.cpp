@@ -0,0 +1,117 @@
+#include "mapped_input.h"
+#include "file_io.h"
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+size_t MappedBlockSource::pageSize() {
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwAllocationGranularity;
+#else
+	long size = sysconf(_SC_PAGESIZE);
+	return size > 0 ? static_cast<size_t>(size) : 4096;
+#endif
+}
+
+MappedBlockSource::MappedBlockSource(const std::string& name, size_t windowBytes,
+	uint64_t offset, uint64_t length)
+	: filename(name), position(offset), window(nullptr), windowLength(0) {
+	//Plan windows from the file size, in whole pages
+	fileSize = FileIO::getFileSize(filename);
+	rangeEnd = length < fileSize - std::min(offset, fileSize) ? offset + length : fileSize;
+	size_t page = pageSize();
+	windowSize = std::max(page, windowBytes / page * page);
+
+#ifdef _WIN32
+	fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("Cannot open input file: " + filename);
+	}
+	mappingHandle = nullptr;
+	if (fileSize > 0) {
+		mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!mappingHandle) {
+			CloseHandle(fileHandle);
+			throw std::runtime_error("Cannot map input file: " + filename);
+		}
+	}
+#else
+	fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw std::runtime_error("Cannot open input file: " + filename);
+	}
+#endif
+}
+
+MappedBlockSource::~MappedBlockSource() {
+	unmapWindow();
+#ifdef _WIN32
+	if (mappingHandle) CloseHandle(mappingHandle);
+	CloseHandle(fileHandle);
+#else
+	close(fd);
+#endif
+}
+
+void MappedBlockSource::unmapWindow() {
+	if (!window) return;
+#ifdef _WIN32
+	UnmapViewOfFile(window);
+#else
+	munmap(window, windowLength);
+#endif
+	window = nullptr;
+	windowLength = 0;
+}
+
+size_t MappedBlockSource::nextBlock(const char*& data) {
+	//The previous window has been fully consumed by the parser
+	unmapWindow();
+	if (position >= rangeEnd) return 0;
+
+	//Mappings start on a page boundary; skip the bytes before position
+	uint64_t mapStart = position / pageSize() * pageSize();
+	size_t skip = static_cast<size_t>(position - mapStart);
+	size_t length = static_cast<size_t>(std::min<uint64_t>(windowSize, rangeEnd - mapStart));
+
+#ifdef _WIN32
+	window = MapViewOfFile(mappingHandle, FILE_MAP_READ,
+		static_cast<DWORD>(mapStart >> 32), static_cast<DWORD>(mapStart & 0xFFFFFFFFu), length);
+	if (!window) {
+		throw std::runtime_error("Cannot map input window: " + filename);
+	}
+#else
+	void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, static_cast<off_t>(mapStart));
+	if (mapped == MAP_FAILED) {
+		throw std::runtime_error("Cannot map input window: " + filename);
+	}
+	window = mapped;
+	madvise(window, length, MADV_SEQUENTIAL);
+#endif
+
+	windowLength = length;
+	position = mapStart + length;
+	data = static_cast<const char*>(window) + skip;
+	return length - skip;
+}
+
+std::unique_ptr<IntParser> openIntInput(const std::string& filename, InputMode mode, const ByteRange& range) {
+	std::unique_ptr<BlockSource> source;
+	if (mode == InputMode::Mapped) {
+		source.reset(new MappedBlockSource(filename, 64 * 1024 * 1024, range.offset, range.length));
+	}
+	else {
+		source.reset(new FileBlockSource(filename, 4 * 1024 * 1024, range.offset, range.length));
+	}
+	return std::unique_ptr<IntParser>(new IntParser(std::move(source), filename, range.offset));
+}
@@ -0,0 +1,52 @@
+#pragma once
+#ifndef MAPPED_INPUT_H
+#define MAPPED_INPUT_H
+
+#include <cstdint>
+#include <string>
+#include "int_parser.h"
+#include "file_io.h"
+#include "sort_options.h"
+
+// BlockSource that memory-maps the input in large windows instead of
+// copying it through a read buffer. Each window is advised for sequential
+// access and unmapped as soon as the parser moves on to the next one, so
+// only one window is resident at a time.
+class MappedBlockSource : public BlockSource {
+private:
+#ifdef _WIN32
+	void* fileHandle;
+	void* mappingHandle;
+#else
+	int fd;
+#endif
+	std::string filename;
+	uint64_t fileSize;
+	uint64_t position;      // Next byte to hand out
+	uint64_t rangeEnd;      // One past the last byte to hand out
+	size_t windowSize;
+	void* window;           // Current mapping (page aligned)
+	size_t windowLength;
+
+	void unmapWindow();
+
+public:
+	explicit MappedBlockSource(const std::string& filename, size_t windowSize = 64 * 1024 * 1024,
+		uint64_t offset = 0, uint64_t length = UINT64_MAX);
+	~MappedBlockSource();
+
+	MappedBlockSource(const MappedBlockSource&) = delete;
+	MappedBlockSource& operator=(const MappedBlockSource&) = delete;
+
+	size_t nextBlock(const char*& data) override;
+
+	// Mapping granularity: window offsets must be multiples of this
+	static size_t pageSize();
+};
+
+// Parser over a text input file (or a byte range of it) read through
+// the reader chosen by mode
+std::unique_ptr<IntParser> openIntInput(const std::string& filename, InputMode mode,
+	const ByteRange& range = ByteRange{ 0, UINT64_MAX });
+
+#endif
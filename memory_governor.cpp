@@ -0,0 +1,139 @@
+#include "memory_governor.h"
+#include "sort_options.h"
+#include "sort_strategy.h"
+#include "utils.h"
+#include <algorithm>
+
+//Smallest chunk the governor hands out, however tight the budget
+static const size_t MIN_GOVERNED_CHUNK = 256 * 1024;
+
+//Smallest merge block budget left after the output buffers
+static const size_t MIN_GOVERNED_MERGE = 1024 * 1024;
+
+//Constructor
+MemoryGovernor::MemoryGovernor(size_t budgetBytes)
+	: budget(budgetBytes), used(0), peak(0) {
+}
+
+size_t MemoryGovernor::planChunkBytes(const SortOptions& options) const {
+	size_t threads = static_cast<size_t>(std::max(options.threadCount, 1));
+	size_t readers = static_cast<size_t>(std::max(options.inputSplits, 1));
+	size_t parseBytes = options.inputMode == InputMode::Stream ? PARSE_BUFFER_BYTES : 0;
+
+	//Chunks held at once, and the sorting threads that add scratch to them
+	size_t buffers, sorters;
+	if (options.sortMode == SortMode::MergeRuns && options.runGeneration == RunGeneration::ReplacementSelection) {
+		//The heap, plus the parked values of the next run
+		buffers = 2 * readers;
+		sorters = 0;
+	}
+	else if (options.sortMode == SortMode::MergeRuns && readers > 1) {
+		buffers = readers;
+		sorters = readers;
+	}
+	else if (threads > 1 && options.chunkSort != SortAlgorithm::ParallelSampleSort) {
+		buffers = threads + 1;
+		sorters = threads;
+	}
+	else {
+		buffers = 1;
+		sorters = 1;
+	}
+	size_t writers = std::max(sorters, readers);
+
+	//Scratch in quarter chunks: the kernel's, plus the half chunk every
+	//sorting thread keeps for merging natural runs
+	size_t scratchQuarters = sortScratchInts(options.chunkSort, 4);
+	if (options.adaptiveChunks) scratchQuarters += 2;
+	size_t quarters = 4 * buffers + scratchQuarters * sorters;
+
+	size_t io = parseBytes * readers + RUN_WRITER_BYTES * writers;
+	size_t available = budget > io ? budget - io : 0;
+	size_t chunk = available / quarters * 4;
+	chunk = chunk / sizeof(int) * sizeof(int);
+	return std::max(chunk, MIN_GOVERNED_CHUNK);
+}
+
+size_t MemoryGovernor::planMergeBytes(const SortOptions& options) const {
+	size_t output;
+	if (options.mergeThreads > 1) {
+		output = INT_WRITER_BYTES * static_cast<size_t>(options.mergeThreads);
+	}
+	else {
+		output = options.asyncOutput ? ASYNC_WRITER_BYTES : INT_WRITER_BYTES;
+	}
+	size_t available = budget > output ? budget - output : 0;
+	return std::max(available, MIN_GOVERNED_MERGE);
+}
+
+void MemoryGovernor::acquire(size_t bytes) {
+	std::lock_guard<std::mutex> lock(mutex);
+	used += bytes;
+	peak = std::max(peak, used);
+	if (!phases.empty()) {
+		phases.back().peak = std::max(phases.back().peak, used);
+	}
+}
+
+void MemoryGovernor::release(size_t bytes) {
+	std::lock_guard<std::mutex> lock(mutex);
+	used -= std::min(bytes, used);
+}
+
+void MemoryGovernor::beginPhase(const std::string& name) {
+	std::lock_guard<std::mutex> lock(mutex);
+	phases.push_back(Phase{ name, used });
+}
+
+size_t MemoryGovernor::getPeak() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return peak;
+}
+
+std::string MemoryGovernor::report() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	std::string text = "peak " + formatSize(peak) + " of " + formatSize(budget);
+	if (!phases.empty()) {
+		text += " (";
+		for (size_t i = 0; i < phases.size(); i++) {
+			if (i > 0) text += ", ";
+			text += phases[i].name + " " + formatSize(phases[i].peak);
+		}
+		text += ")";
+	}
+	if (peak > budget) {
+		text += ", over budget";
+	}
+	return text;
+}
+
+MemoryReservation::MemoryReservation(MemoryGovernor* gov, size_t size)
+	: governor(gov), bytes(0) {
+	reset(size);
+}
+
+MemoryReservation::MemoryReservation(MemoryReservation&& other)
+	: governor(other.governor), bytes(other.bytes) {
+	other.bytes = 0;
+}
+
+MemoryReservation& MemoryReservation::operator=(MemoryReservation&& other) {
+	if (this != &other) {
+		reset();
+		governor = other.governor;
+		bytes = other.bytes;
+		other.bytes = 0;
+	}
+	return *this;
+}
+
+void MemoryReservation::reset(size_t size) {
+	if (!governor) return;
+	if (size > bytes) {
+		governor->acquire(size - bytes);
+	}
+	else {
+		governor->release(bytes - size);
+	}
+	bytes = size;
+}
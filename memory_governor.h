@@ -0,0 +1,95 @@
+#pragma once
+#ifndef MEMORY_GOVERNOR_H
+#define MEMORY_GOVERNOR_H
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct SortOptions;
+
+// One memory budget for the whole sort (--memory).
+//
+// Before a phase runs, the governor splits the budget between what that
+// phase allocates: chunk buffers, sort kernel scratch and parse/run
+// writer buffers while chunking; read blocks and output buffers while
+// merging. The counting and distribution paths size themselves from the
+// same budget. The components then
+// register each large allocation through a MemoryReservation, so the
+// governor knows what is actually held and reports the peak of the whole
+// job and of every phase. Small objects and the page cache behind mmap'd
+// input are not counted.
+class MemoryGovernor {
+private:
+	struct Phase {
+		std::string name;
+		size_t peak;
+	};
+
+	size_t budget;
+	mutable std::mutex mutex;
+	size_t used;
+	size_t peak;
+	std::vector<Phase> phases;
+
+public:
+	// Buffers of the readers and writers (defaults in int_parser.h,
+	// run_format.h and int_writer.h): a stream parser's block, a run
+	// writer, an IntWriter's format buffer, and an AsyncIntWriter's two
+	// int buffers in front of its IntWriter
+	static constexpr size_t PARSE_BUFFER_BYTES = 4 * 1024 * 1024;
+	static constexpr size_t RUN_WRITER_BYTES = 64 * 1024 * sizeof(int);
+	static constexpr size_t INT_WRITER_BYTES = 1024 * 1024;
+	static constexpr size_t ASYNC_WRITER_BYTES = INT_WRITER_BYTES + 2 * 256 * 1024 * sizeof(int);
+
+	explicit MemoryGovernor(size_t budgetBytes);
+
+	MemoryGovernor(const MemoryGovernor&) = delete;
+	MemoryGovernor& operator=(const MemoryGovernor&) = delete;
+
+	// Bytes per chunk for the chunking phase with these options: the
+	// buffers in flight plus the kernel's scratch for every sorting thread,
+	// after the parse and run writer buffers (at least 1 MB)
+	size_t planChunkBytes(const SortOptions& options) const;
+
+	// Bytes for merge read blocks once the output buffers are set aside
+	size_t planMergeBytes(const SortOptions& options) const;
+
+	// Track an allocation of `bytes` (never fails; going over is reported)
+	void acquire(size_t bytes);
+	void release(size_t bytes);
+
+	// Start a named phase; its peak is tracked separately
+	void beginPhase(const std::string& name);
+
+	size_t getBudget() const { return budget; }
+	size_t getPeak() const;
+
+	// "peak X of Y (chunking A, merging B)"
+	std::string report() const;
+};
+
+// RAII registration of one allocation with a governor (which may be null)
+class MemoryReservation {
+private:
+	MemoryGovernor* governor;
+	size_t bytes;
+
+public:
+	MemoryReservation() : governor(nullptr), bytes(0) {}
+	MemoryReservation(MemoryGovernor* governor, size_t bytes);
+	~MemoryReservation() { reset(); }
+
+	MemoryReservation(const MemoryReservation&) = delete;
+	MemoryReservation& operator=(const MemoryReservation&) = delete;
+
+	// Moving hands the bytes over, e.g. along with the buffer they count
+	MemoryReservation(MemoryReservation&& other);
+	MemoryReservation& operator=(MemoryReservation&& other);
+
+	// Release the bytes held so far and hold `size` bytes instead
+	void reset(size_t size = 0);
+};
+
+#endif
@@ -0,0 +1,201 @@
+#include "merge_inputs.h"
+#include "run_format.h"
+#include "utils.h"
+#include "file_io.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+const size_t NO_RUN = static_cast<size_t>(-1);
+
+}
+
+MergeInputs::MergeInputs(const std::vector<std::string>& filenames, BlockPool& blockPool, bool async,
+	const std::vector<RunSlice>& slices)
+	: pool(blockPool), readAhead(async), stopping(false), waitingRun(NO_RUN),
+	stallSeconds(0), stalls(0), blocksRead(0) {
+	if (pool.getBlockCount() < filenames.size()) {
+		throw std::runtime_error("Merge needs at least one read block per run");
+	}
+	if (!slices.empty() && slices.size() != filenames.size()) {
+		throw std::runtime_error("Merge needs one slice per run");
+	}
+
+	runs.reserve(filenames.size());
+	try {
+		for (const std::string& name : filenames) {
+			std::FILE* file = std::fopen(name.c_str(), "rb");
+			if (!file) {
+				throw std::runtime_error("Cannot open run file: " + name);
+			}
+			runs.push_back(Run{ file, name, 0, std::deque<Block>(), INT64_MIN, false, nullptr });
+			Run& run = runs.back();
+
+			//Reads are whole blocks: skip the stdio buffer and its extra copy
+			std::setvbuf(file, nullptr, _IONBF, 0);
+			RunHeader header = readRunHeader(file, name);
+			run.unread = header.count;
+			if (isPackedRun(header)) {
+				run.packed.reset(new PackedRunReader(file, name, header.count));
+			}
+
+			if (!slices.empty()) {
+				const RunSlice& slice = slices[runs.size() - 1];
+				if (slice.start + slice.count > run.unread) {
+					throw std::runtime_error("Run slice out of range: " + name);
+				}
+				if (run.packed) {
+					run.packed->seek(slice.start);
+				}
+				else if (!FileIO::seek(file, sizeof(RunHeader) + slice.start * sizeof(int))) {
+					throw std::runtime_error("Run slice out of range: " + name);
+				}
+				run.unread = slice.count;
+			}
+		}
+	}
+	catch (...) {
+		for (Run& run : runs) std::fclose(run.file);
+		throw;
+	}
+	cursors.assign(runs.size(), Cursor{ nullptr, 0, 0, nullptr });
+
+	if (readAhead) {
+		ioThread = std::thread(&MergeInputs::ioLoop, this);
+	}
+}
+
+MergeInputs::~MergeInputs() {
+	stop();
+	for (Run& run : runs) {
+		std::fclose(run.file);
+	}
+}
+
+void MergeInputs::stop() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	workCv.notify_all();
+	if (ioThread.joinable()) {
+		ioThread.join();
+	}
+}
+
+void MergeInputs::readBlock(Run& run, Block& block) {
+	size_t got = run.packed ? run.packed->read(block.data, block.count)
+		: std::fread(block.data, sizeof(int), block.count, run.file);
+	if (got != block.count) {
+		throw std::runtime_error("Truncated run file: " + run.filename);
+	}
+}
+
+//Cursor ran dry: move on to the run's next block
+bool MergeInputs::advance(size_t index) {
+	Cursor& cursor = cursors[index];
+	Run& run = runs[index];
+
+	if (!readAhead) {
+		//Synchronous: every run keeps one block and refills it in place
+		if (run.unread == 0) return false;
+		if (!cursor.block) cursor.block = pool.acquire();
+
+		Block block{ cursor.block, static_cast<size_t>(std::min<uint64_t>(run.unread, pool.getBlockInts())) };
+		readBlock(run, block);
+		run.unread -= block.count;
+		blocksRead++;
+		cursor = Cursor{ block.data, 0, block.count, block.data };
+		return true;
+	}
+
+	std::unique_lock<std::mutex> lock(mutex);
+
+	//The finished block is free for read-ahead right away
+	if (cursor.block) {
+		pool.release(cursor.block);
+		cursor = Cursor{ nullptr, 0, 0, nullptr };
+		workCv.notify_one();
+	}
+
+	if (run.ready.empty() && (run.unread > 0 || run.reading) && !error) {
+		//Stall: this run jumps the forecast queue
+		waitingRun = index;
+		workCv.notify_one();
+
+		Timer timer;
+		readyCv.wait(lock, [&]() {
+			return !run.ready.empty() || error || (run.unread == 0 && !run.reading);
+		});
+		stallSeconds += timer.elapsed();
+		stalls++;
+		waitingRun = NO_RUN;
+	}
+
+	if (error) {
+		std::rethrow_exception(error);
+	}
+	if (run.ready.empty()) return false;
+
+	Block block = run.ready.front();
+	run.ready.pop_front();
+	cursor = Cursor{ block.data, 0, block.count, block.data };
+	return true;
+}
+
+//Forecasting: the run whose newest block ends lowest runs dry first.
+//Called with the mutex held.
+bool MergeInputs::pickRun(size_t& index) const {
+	if (waitingRun != NO_RUN) {
+		const Run& waiting = runs[waitingRun];
+		if (waiting.unread > 0 && !waiting.reading && waiting.ready.empty()) {
+			index = waitingRun;
+			return true;
+		}
+	}
+
+	size_t best = NO_RUN;
+	for (size_t i = 0; i < runs.size(); i++) {
+		if (runs[i].unread == 0 || runs[i].reading) continue;
+		if (best == NO_RUN || runs[i].forecast < runs[best].forecast) best = i;
+	}
+	index = best;
+	return best != NO_RUN;
+}
+
+//Background reader: fill every free block, in forecast order
+void MergeInputs::ioLoop() {
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;) {
+		size_t index = NO_RUN;
+		workCv.wait(lock, [&]() {
+			return stopping || (pool.getFreeCount() > 0 && pickRun(index));
+		});
+		if (stopping) return;
+
+		Run& run = runs[index];
+		Block block{ pool.acquire(), static_cast<size_t>(std::min<uint64_t>(run.unread, pool.getBlockInts())) };
+		run.unread -= block.count;
+		run.reading = true;
+
+		lock.unlock();
+		try {
+			readBlock(run, block);
+		}
+		catch (...) {
+			lock.lock();
+			error = std::current_exception();
+			run.reading = false;
+			readyCv.notify_all();
+			return;
+		}
+		lock.lock();
+
+		run.reading = false;
+		run.forecast = block.data[block.count - 1];
+		run.ready.push_back(block);
+		blocksRead++;
+		readyCv.notify_all();
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+#ifndef MERGE_INPUTS_H
+#define MERGE_INPUTS_H
+
+#include <cstdio>
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "block_pool.h"
+#include "run_codec.h"
+
+// Part of a run to merge: `count` values starting at value index `start`
+struct RunSlice {
+	uint64_t start;
+	uint64_t count;
+};
+
+// Block-buffered input side of the merge: one cursor per run, refilled
+// with whole blocks from a shared BlockPool.
+//
+// With read-ahead on, a background I/O thread fills every spare block in
+// forecasting order: the run whose most recently read block ends with
+// the smallest key will run dry first, so its next block is read first.
+// A run the merge is already waiting on always goes to the front. The
+// merge only blocks when the disk is behind, and that time is reported
+// as stall time. Without read-ahead, blocks are read on the merge thread
+// when a cursor runs dry. Packed runs are decoded into the blocks by
+// whichever thread reads them.
+class MergeInputs {
+private:
+	struct Block {
+		int* data;
+		size_t count;
+	};
+
+	// Consumer-side cursor, touched only by the merge thread
+	struct Cursor {
+		const int* data;
+		size_t position;
+		size_t count;
+		int* block;      // Block to hand back to the pool when done
+	};
+
+	// Shared run state, guarded by mutex
+	struct Run {
+		std::FILE* file;
+		std::string filename;
+		uint64_t unread;            // Values not yet read from disk
+		std::deque<Block> ready;    // Blocks read ahead, oldest first
+		int64_t forecast;           // Last key of the newest block read
+		bool reading;               // The I/O thread is filling a block
+		std::unique_ptr<PackedRunReader> packed;   // Decoder of a packed run
+	};
+
+	BlockPool& pool;
+	bool readAhead;
+	std::vector<Cursor> cursors;
+	std::vector<Run> runs;
+
+	std::mutex mutex;
+	std::condition_variable readyCv;   // Signals the merge thread
+	std::condition_variable workCv;    // Signals the I/O thread
+	std::thread ioThread;
+	bool stopping;
+	size_t waitingRun;
+	std::exception_ptr error;
+
+	double stallSeconds;
+	size_t stalls;
+	size_t blocksRead;
+
+	bool advance(size_t run);
+	bool pickRun(size_t& run) const;
+	void readBlock(Run& run, Block& block);
+	void ioLoop();
+	void stop();
+
+public:
+	// The pool must hold at least one block per run; with read-ahead the
+	// blocks beyond that are the read-ahead window. With slices (one per
+	// run) only that part of each run is read.
+	MergeInputs(const std::vector<std::string>& filenames, BlockPool& pool, bool readAhead,
+		const std::vector<RunSlice>& slices = std::vector<RunSlice>());
+	~MergeInputs();
+
+	MergeInputs(const MergeInputs&) = delete;
+	MergeInputs& operator=(const MergeInputs&) = delete;
+
+	// Read next value of a run; returns false at end of run
+	bool next(size_t run, int& value) {
+		Cursor& cursor = cursors[run];
+		if (cursor.position == cursor.count && !advance(run)) return false;
+		value = cursor.data[cursor.position++];
+		return true;
+	}
+
+	size_t getRunCount() const { return cursors.size(); }
+	double getStallSeconds() const { return stallSeconds; }   // Merge thread waiting on a read
+	size_t getStalls() const { return stalls; }
+	size_t getBlocksRead() const { return blocksRead; }
+};
+
+#endif
@@ -0,0 +1,135 @@
+#include "merge_partition.h"
+#include "run_format.h"
+#include "file_io.h"
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+//Values sampled across all runs to place the splitters
+const size_t TOTAL_SAMPLES = 16 * 1024;
+
+//Binary search reads single values until the window is this small
+const size_t SEARCH_WINDOW = 4096;
+
+//Random access to the values of one run file
+class RunFile {
+private:
+	std::FILE* file;
+	std::string filename;
+	uint64_t count;
+	std::unique_ptr<PackedRunReader> packed;   //Packed runs decode the frame holding the index
+
+public:
+	explicit RunFile(const std::string& name) : file(nullptr), filename(name), count(0) {
+		file = std::fopen(name.c_str(), "rb");
+		if (!file) {
+			throw std::runtime_error("Cannot open run file: " + name);
+		}
+		try {
+			RunHeader header = readRunHeader(file, name);
+			count = header.count;
+			if (isPackedRun(header)) {
+				packed.reset(new PackedRunReader(file, name, count));
+			}
+		}
+		catch (...) {
+			std::fclose(file);
+			throw;
+		}
+	}
+	~RunFile() { std::fclose(file); }
+
+	RunFile(const RunFile&) = delete;
+	RunFile& operator=(const RunFile&) = delete;
+
+	uint64_t size() const { return count; }
+
+	void read(uint64_t index, int* dst, size_t n) {
+		if (packed) {
+			packed->seek(index);
+			if (packed->read(dst, n) != n) {
+				throw std::runtime_error("Truncated run file: " + filename);
+			}
+			return;
+		}
+		if (!FileIO::seek(file, sizeof(RunHeader) + index * sizeof(int)) ||
+			std::fread(dst, sizeof(int), n, file) != n) {
+			throw std::runtime_error("Truncated run file: " + filename);
+		}
+	}
+
+	int at(uint64_t index) {
+		int value;
+		read(index, &value, 1);
+		return value;
+	}
+
+	//Index of the first value >= key in [lo, hi)
+	uint64_t lowerBound(int key, uint64_t lo, uint64_t hi) {
+		while (hi - lo > SEARCH_WINDOW) {
+			uint64_t mid = lo + (hi - lo) / 2;
+			if (at(mid) < key) lo = mid + 1;
+			else hi = mid;
+		}
+		std::vector<int> window(static_cast<size_t>(hi - lo));
+		if (!window.empty()) read(lo, window.data(), window.size());
+		return lo + (std::lower_bound(window.begin(), window.end(), key) - window.begin());
+	}
+};
+
+}
+
+std::vector<std::vector<RunSlice>> partitionRuns(const std::vector<std::string>& files, size_t parts) {
+	parts = std::max<size_t>(parts, 1);
+	size_t runCount = files.size();
+
+	std::vector<std::unique_ptr<RunFile>> runs;
+	uint64_t total = 0;
+	for (const std::string& name : files) {
+		runs.emplace_back(new RunFile(name));
+		total += runs.back()->size();
+	}
+
+	//Evenly spaced samples, each standing for its share of the run
+	std::vector<std::pair<int, double>> samples;
+	size_t perRun = std::max<size_t>(4, TOTAL_SAMPLES / std::max<size_t>(runCount, 1));
+	for (auto& run : runs) {
+		uint64_t n = run->size();
+		if (n == 0) continue;
+		size_t count = static_cast<size_t>(std::min<uint64_t>(n, perRun));
+		double weight = static_cast<double>(n) / count;
+		for (size_t j = 0; j < count; j++) {
+			samples.push_back(std::make_pair(run->at(n * j / count), weight));
+		}
+	}
+	std::sort(samples.begin(), samples.end());
+
+	//Splitter p: first sample where the weight so far reaches p/P of the total
+	std::vector<int> splitters;
+	double seen = 0;
+	size_t next = 1;
+	for (size_t i = 0; i < samples.size() && next < parts; i++) {
+		seen += samples[i].second;
+		while (next < parts && seen >= static_cast<double>(total) * next / parts) {
+			splitters.push_back(samples[i].first);
+			next++;
+		}
+	}
+
+	//Cut every run at every splitter; cuts only move forward
+	std::vector<std::vector<RunSlice>> slices(parts, std::vector<RunSlice>(runCount, RunSlice{ 0, 0 }));
+	for (size_t r = 0; r < runCount; r++) {
+		uint64_t n = runs[r]->size();
+		uint64_t start = 0;
+		for (size_t p = 0; p < parts; p++) {
+			uint64_t end = p < splitters.size() ? runs[r]->lowerBound(splitters[p], start, n) : n;
+			slices[p][r] = RunSlice{ start, end - start };
+			start = end;
+		}
+	}
+	return slices;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#ifndef MERGE_PARTITION_H
+#define MERGE_PARTITION_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "merge_inputs.h"
+
+// Splits the merge of sorted runs into disjoint key ranges that can be
+// merged independently (multiway selection).
+//
+// Splitter keys are picked from a sample of every run, weighted by run
+// size, at the 1/P, 2/P, ... quantiles. Each run is then cut at the first
+// value >= each splitter by binary search over the run file. Part p holds
+// every value in [splitter p-1, splitter p) of every run, so merging the
+// parts one after another gives exactly the sequential merge. Runs with
+// many copies of one key can leave some parts small or empty.
+//
+// Returns slices[part][run]; the slices of a part line up with `files`.
+std::vector<std::vector<RunSlice>> partitionRuns(const std::vector<std::string>& files, size_t parts);
+
+#endif
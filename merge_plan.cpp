@@ -0,0 +1,74 @@
+#include "merge_plan.h"
+#include "heap.h"
+#include <algorithm>
+#include <utility>
+
+MergePlan planMerge(const std::vector<uint64_t>& runSizes, size_t fanIn) {
+	MergePlan plan;
+	plan.fanIn = std::max<size_t>(fanIn, 2);
+	size_t runCount = runSizes.size();
+	if (runCount == 0) return plan;
+
+	//Merge level of every run, original runs are level 0
+	std::vector<int> level(runCount, 0);
+
+	//Few enough runs: a single merge, in input order
+	if (runCount <= plan.fanIn) {
+		MergeStep step;
+		for (size_t i = 0; i < runCount; i++) {
+			step.inputs.push_back(i);
+			step.elements += runSizes[i];
+		}
+		step.output = runCount;
+		plan.steps.push_back(step);
+		plan.depth = 1;
+		return plan;
+	}
+
+	//(size, id) min-heap: equal sizes merge in id order
+	typedef std::pair<uint64_t, size_t> SizedRun;
+	DaryHeap<SizedRun> pending;
+	for (size_t i = 0; i < runCount; i++) {
+		pending.insert(SizedRun(runSizes[i], i));
+	}
+
+	//First merge takes the remainder so every later one is full
+	size_t take = (runCount - 2) % (plan.fanIn - 1) + 2;
+	size_t nextId = runCount;
+	while (true) {
+		bool final = pending.size() <= plan.fanIn;
+		if (final) take = pending.size();
+
+		MergeStep step;
+		int stepLevel = 0;
+		for (size_t i = 0; i < take; i++) {
+			SizedRun run = pending.extractMin();
+			step.inputs.push_back(run.second);
+			step.elements += run.first;
+			stepLevel = std::max(stepLevel, level[run.second]);
+		}
+		step.output = nextId++;
+		level.push_back(stepLevel + 1);
+		plan.steps.push_back(step);
+
+		if (final) {
+			plan.depth = stepLevel + 1;
+			break;
+		}
+		plan.elementsRewritten += step.elements;
+		pending.insert(SizedRun(step.elements, step.output));
+		take = plan.fanIn;
+	}
+	return plan;
+}
+
+size_t chooseFanIn(size_t budgetBytes, size_t blocksPerRun, size_t minBlockBytes, size_t fileLimit) {
+	size_t perRun = std::max<size_t>(blocksPerRun, 1) * std::max<size_t>(minBlockBytes, 1);
+	size_t byMemory = budgetBytes / perRun;
+
+	//Keep descriptors for stdio, the output file and the writer's spares
+	const size_t RESERVED_FILES = 16;
+	size_t byFiles = fileLimit > RESERVED_FILES + 2 ? fileLimit - RESERVED_FILES : 2;
+
+	return std::max<size_t>(std::min(byMemory, byFiles), 2);
+}
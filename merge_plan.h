@@ -0,0 +1,39 @@
+#pragma once
+#ifndef MERGE_PLAN_H
+#define MERGE_PLAN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One merge of the schedule. Run ids below the input run count are the
+// original runs; every step produces the next id in order.
+struct MergeStep {
+	std::vector<size_t> inputs;
+	size_t output = 0;
+	uint64_t elements = 0;     // Elements the step reads (and writes)
+};
+
+// Cascaded merge schedule with bounded fan-in. The last step is the final
+// merge into the output file; the others write intermediate runs.
+struct MergePlan {
+	size_t fanIn = 0;
+	std::vector<MergeStep> steps;
+	int depth = 0;                    // Longest chain of merges an element goes through
+	uint64_t elementsRewritten = 0;   // Elements written to intermediate runs
+
+	size_t getIntermediateMerges() const { return steps.empty() ? 0 : steps.size() - 1; }
+};
+
+// Optimal schedule for merging runs of the given sizes, at most fanIn at
+// a time (k-ary Huffman): the smallest runs are merged first, and the
+// first merge takes just enough runs that every later one, including the
+// final merge, is a full fanIn-way merge. This minimises the elements
+// rewritten to intermediate runs.
+MergePlan planMerge(const std::vector<uint64_t>& runSizes, size_t fanIn);
+
+// Largest fan-in that keeps blocksPerRun blocks of at least minBlockBytes
+// per run within budgetBytes, and stays below the open-file limit
+size_t chooseFanIn(size_t budgetBytes, size_t blocksPerRun, size_t minBlockBytes, size_t fileLimit);
+
+#endif
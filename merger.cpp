@@ -1,7 +1,18 @@
 #include "merger.h"
 #include "utils.h"
+#include "int_writer.h"
+#include "file_io.h"
+#include "run_format.h"
+#include "merge_partition.h"
+#include "temp_files.h"
 #include <iostream>
+#include <iomanip>
+#include <algorithm>
 #include <stdexcept>
+#include <thread>
+#include <mutex>
+#include <exception>
+#include <cstdint>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -20,9 +31,23 @@ void setMergerColor(int color) {
 #define COLOR_WHITE 0
 #endif
 
+//Merge read blocks when no budget is given
+static const size_t DEFAULT_MERGE_BUDGET = 64 * 1024 * 1024;
+
+//Smallest block worth reading per run; bounds fan-in by memory
+static const size_t MIN_FAN_IN_BLOCK = 64 * 1024;
+
+//Fewest elements per thread worth a parallel merge
+static const uint64_t MIN_PARALLEL_MERGE = 256 * 1024;
+
+//Copy buffer for appending merge segments to the output
+static const size_t SEGMENT_COPY_BYTES = 4 * 1024 * 1024;
+
 //Constructor
-Merger::Merger(const std::vector<std::string>& chunks, const std::string& output)
-	: chunkFilenames(chunks), outputFilename(output) {
+Merger::Merger(const std::vector<std::string>& chunks, const std::string& output,
+	const SortOptions& opts)
+	: chunkFilenames(chunks), outputFilename(output), options(opts), blockMemory(opts.memory, 0), bytesRewritten(0),
+	stallSeconds(0), blocksRead(0), stalls(0) {
 	
 	if (chunks.empty()) {
 		throw std::runtime_error("No chunks to merge");
@@ -35,48 +60,224 @@ Merger::Merger(const std::vector<std::string>& chunks, const std::string& output
 
 //Destructor
 Merger::~Merger() {
-	closeAllChunks();
+	closeRuns();
+	removeIntermediates();
 }
 
-//Open all chunk files
-void Merger::openAllChunks() {
-	chunkStreams.resize(chunkFilenames.size());
+//Most runs one merge may open: bounded by memory and by the fd limit
+size_t Merger::maxFanIn(const SortOptions& options) {
+	size_t blocksPerRun = options.mergeReadAhead ? 2 : 1;
+	size_t budget = options.mergeMemoryBudget > 0 ? options.mergeMemoryBudget : DEFAULT_MERGE_BUDGET;
+	size_t minBlock = options.mergeBlockSize > 0 ? options.mergeBlockSize : MIN_FAN_IN_BLOCK;
+	size_t fanIn = chooseFanIn(budget, blocksPerRun, minBlock, FileIO::maxOpenFiles());
+	if (options.maxFanIn > 0) {
+		fanIn = std::min(fanIn, std::max<size_t>(options.maxFanIn, 2));
+	}
+	return fanIn;
+}
 
-	for (size_t i = 0; i < chunkFilenames.size(); i++) {
-		chunkStreams[i].open(chunkFilenames[i]);
+//Temp file for an intermediate run
+std::string Merger::getIntermediateFilename(size_t runId) const {
+	return TempFiles::place(options.temp, "temp_merge_" + std::to_string(runId) + ".run");
+}
 
-		if(!chunkStreams[i].is_open()) {
-			throw std::runtime_error("Cannot open chunk files: " + chunkFilenames[i]);
-		}
+//Temp file for one key range of a parallel merge
+std::string Merger::getSegmentFilename(size_t part) const {
+	return TempFiles::place(options.temp, "temp_segment_" + std::to_string(part) + ".txt");
+}
 
-		//read first elements from each chunk into help
-		readNextFromChunk(i);
+//Open the runs of one merge step
+void Merger::openRuns(const std::vector<std::string>& files) {
+	size_t runCount = files.size();
+	tree.reset(runCount);
+
+	//One large block per run, plus as many again for read-ahead,
+	//all from a single pool within the budget
+	size_t blocksPerRun = options.mergeReadAhead ? 2 : 1;
+	size_t budget = options.mergeMemoryBudget > 0 ? options.mergeMemoryBudget : DEFAULT_MERGE_BUDGET;
+	size_t blockBytes = options.mergeBlockSize > 0 ? options.mergeBlockSize
+		: BlockPool::chooseBlockSize(runCount, blocksPerRun, budget);
+	blockMemory.reset();
+	blockPool.reset(blockBytes, runCount * blocksPerRun, options.buffers);
+	blockMemory.reset(blockPool.getBlockBytes() * blockPool.getBlockCount());
+
+	//Throws if a file is missing or not a valid run
+	inputs.reset(new MergeInputs(files, blockPool, options.mergeReadAhead));
+
+	//read first elements from each chunk into the tree
+	for (size_t i = 0; i < runCount; i++) {
+		int value;
+		if (inputs->next(i, value)) {
+			tree.setSource(static_cast<int>(i), value);
+		}
 	}
-	std::cout << "All " << chunkFilenames.size() << " chunks opened\n";
+	tree.build();
 }
 //Clode all chunk files
-void Merger::closeAllChunks() {
-	for (auto& stream : chunkStreams) {
-		if (stream.is_open()) {
-			stream.close();
+void Merger::closeRuns() {
+	if (inputs) {
+		stallSeconds += inputs->getStallSeconds();
+		blocksRead += inputs->getBlocksRead();
+		stalls += inputs->getStalls();
+		inputs.reset();
+	}
+}
+//Delete intermediate runs left behind (e.g. after an error)
+void Merger::removeIntermediates() {
+	for (const std::string& file : intermediateFiles) {
+		std::remove(file.c_str());
+	}
+	intermediateFiles.clear();
+}
+//Merge loop: pull the winner, write it, replay its run
+template <typename Writer>
+static size_t mergeRuns(LoserTree& tree, MergeInputs& inputs, Writer& output, bool showProgress) {
+	size_t totalMerged = 0;
+	size_t progressInterval = 100000; // Update
+	size_t untilProgress = progressInterval;
+
+	//K-way merge using the loser tree
+	while (!tree.isEmpty()) {
+		//Write minimum element to output
+		int chunkIndex = tree.winner();
+		output.write(tree.winnerKey());
+		totalMerged++;
+
+		//Progress indicator
+		if (--untilProgress == 0) {
+			untilProgress = progressInterval;
+			if (showProgress) {
+				std::cout << "\nMerged: " << (totalMerged / 1000000.0) << " M elements..."
+					<< std::flush;
+			}
+		}
+		//Next element from the same chunk replays the winner's path
+		int value;
+		if (inputs.next(chunkIndex, value)) {
+			tree.replaceWinner(value);
+		}
+		else {
+			tree.exhaustWinner();
 		}
 	}
+	return totalMerged;
 }
-//Read next integer from specific chunk
-bool Merger::readNextFromChunk(int chunkIndex) {
-	if (chunkIndex >= static_cast<int>(chunkStreams.size())) {
-		return false;
+
+template <typename Writer>
+size_t Merger::mergeInto(Writer& output, bool showProgress) {
+	return mergeRuns(tree, *inputs, output, showProgress);
+}
+
+//Final merge split into key ranges, one thread each. Part 0 goes
+//straight to the output file, the others to segment files that are
+//appended in order afterwards.
+size_t Merger::mergePartitioned(const std::vector<std::string>& files, size_t parts, double& syncTime) {
+	size_t runCount = files.size();
+	std::vector<std::vector<RunSlice>> slices = partitionRuns(files, parts);
+
+	//The merge budget is shared by all parts
+	size_t blocksPerRun = options.mergeReadAhead ? 2 : 1;
+	size_t budget = (options.mergeMemoryBudget > 0 ? options.mergeMemoryBudget : DEFAULT_MERGE_BUDGET) / parts;
+	size_t blockBytes = options.mergeBlockSize > 0 ? options.mergeBlockSize
+		: BlockPool::chooseBlockSize(runCount, blocksPerRun, budget);
+
+	std::vector<std::string> targets;
+	for (size_t p = 0; p < parts; p++) {
+		if (p == 0) {
+			targets.push_back(outputFilename);
+		}
+		else {
+			targets.push_back(getSegmentFilename(p));
+			intermediateFiles.push_back(targets.back());
+		}
 	}
 
-	int value;
-	if (chunkStreams[chunkIndex] >> value) {
-		MergeElement element;
-		element.value = value;
-		element.chunkIndex = chunkIndex;
-		minHeap.push(element);
-		return true;
+	std::cout << "Parallel merge: " << parts << " key ranges, " << runCount << " runs, read blocks "
+		<< parts << " x " << runCount * blocksPerRun << " x " << formatSize(blockBytes) << "\n";
+
+	//Each part formats its own output on its own thread
+	std::vector<size_t> merged(parts, 0);
+	std::vector<std::thread> workers;
+	std::mutex statsMutex;
+	std::exception_ptr error;
+	for (size_t p = 0; p < parts; p++) {
+		workers.emplace_back([&, p]() {
+			try {
+				BlockPool pool(blockBytes, runCount * blocksPerRun, options.buffers);
+				MemoryReservation partMemory(options.memory,
+					pool.getBlockBytes() * pool.getBlockCount() + MemoryGovernor::INT_WRITER_BYTES);
+				MergeInputs partInputs(files, pool, options.mergeReadAhead, slices[p]);
+				LoserTree partTree(runCount);
+				for (size_t i = 0; i < runCount; i++) {
+					int value;
+					if (partInputs.next(i, value)) {
+						partTree.setSource(static_cast<int>(i), value);
+					}
+				}
+				partTree.build();
+
+				IntWriter output(targets[p]);
+				merged[p] = mergeRuns(partTree, partInputs, output, false);
+				output.close();
+
+				std::lock_guard<std::mutex> lock(statsMutex);
+				stallSeconds += partInputs.getStallSeconds();
+				blocksRead += partInputs.getBlocksRead();
+				stalls += partInputs.getStalls();
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock(statsMutex);
+				if (!error) error = std::current_exception();
+			}
+		});
+	}
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+	if (error) {
+		std::rethrow_exception(error);
+	}
+
+	//Append the segments behind part 0
+	std::FILE* out = std::fopen(outputFilename.c_str(), "ab");
+	if (!out) {
+		throw std::runtime_error("Cannot open output file: " + outputFilename);
+	}
+	std::vector<char> buffer(SEGMENT_COPY_BYTES);
+	MemoryReservation copyMemory(options.memory, SEGMENT_COPY_BYTES);
+	bool ok = true;
+	for (size_t p = 1; p < parts && ok; p++) {
+		std::FILE* in = std::fopen(targets[p].c_str(), "rb");
+		if (!in) {
+			ok = false;
+			break;
+		}
+		size_t bytes;
+		while ((bytes = std::fread(buffer.data(), 1, buffer.size(), in)) > 0) {
+			if (std::fwrite(buffer.data(), 1, bytes, out) != bytes) {
+				ok = false;
+				break;
+			}
+		}
+		std::fclose(in);
+	}
+	if (ok && options.syncOutput) {
+		Timer syncTimer;
+		ok = FileIO::syncData(out);
+		syncTime = syncTimer.elapsed();
 	}
-	return false; //No more data in this chunk
+	if (std::fclose(out) != 0) ok = false;
+	if (!ok) {
+		throw std::runtime_error("Error writing output file: " + outputFilename);
+	}
+	removeIntermediates();
+
+	size_t totalMerged = 0;
+	for (size_t p = 0; p < parts; p++) {
+		std::cout << " Part " << p << ": " << merged[p] << " integers\n";
+		totalMerged += merged[p];
+	}
+	return totalMerged;
 }
 
 //Main merge operation
@@ -86,44 +287,119 @@ void Merger::merge() {
 	setMergerColor(COLOR_WHITE);
 
 	Timer timer;
+	bytesRewritten = 0;
+	stallSeconds = 0;
+	blocksRead = 0;
+	stalls = 0;
+
+	//Plan the merge from the run sizes in the headers
+	std::vector<std::string> runFiles = chunkFilenames;
+	std::vector<uint64_t> runSizes;
+	uint64_t runBytes = 0;
+	for (const std::string& file : runFiles) {
+		runSizes.push_back(RunReader(file, 1).getHeader().count);
+		runBytes += FileIO::getFileSize(file);
+	}
+	plan = planMerge(runSizes, maxFanIn(options));
+	std::cout << "Merge plan: fan-in " << plan.fanIn << ", " << plan.getIntermediateMerges()
+		<< " intermediate merges, " << plan.depth << " pass(es) deep\n";
+
+	//Intermediate merges, smallest runs first; inputs written by an
+	//earlier step are deleted as soon as they have been consumed
+	for (size_t s = 0; s + 1 < plan.steps.size(); s++) {
+		const MergeStep& step = plan.steps[s];
+		std::vector<std::string> files;
+		for (size_t id : step.inputs) files.push_back(runFiles[id]);
+
+		std::string target = getIntermediateFilename(step.output);
+		runFiles.push_back(target);
+		intermediateFiles.push_back(target);
 
-	//Open all chunk files
-	std::cout << "Opening chunk files...\n";
-	openAllChunks();
+		openRuns(files);
+		MemoryReservation writerMemory(options.memory, MemoryGovernor::RUN_WRITER_BYTES);
+		RunWriter writer(target, 64 * 1024, options.compressRuns);
+		mergeInto(writer, false);
+		writer.close();
+		closeRuns();
 
-	//Open output file
-	std::ofstream output(outputFilename);
-	if (!output.is_open()) {
-		throw std::runtime_error("Cannot create output file: " + outputFilename);
+		bytesRewritten += writer.getBytesWritten();
+		for (const std::string& file : files) {
+			auto it = std::find(intermediateFiles.begin(), intermediateFiles.end(), file);
+			if (it != intermediateFiles.end()) {
+				std::remove(file.c_str());
+				intermediateFiles.erase(it);
+			}
+		}
+		std::cout << " Merged " << files.size() << " runs into " << target
+			<< " (" << writer.getCount() << " integers)\n";
 	}
 
-	std::cout << " Starting " << chunkFilenames.size() << "-wahy merge...\n";
-	
-	size_t totalMerged = 0;
-	size_t progressInterval = 100000; // Update
+	//Final merge into the output file
+	const MergeStep& last = plan.steps.back();
+	std::vector<std::string> files;
+	for (size_t id : last.inputs) files.push_back(runFiles[id]);
 
-	//K-way merge using minHeap
-	while (!minHeap.empty()) {
-		//Extract minium element
-		MergeElement minElement = minHeap.top();
-		minHeap.pop();
+	//Output stage (throws if the file cannot be created)
+	size_t totalMerged;
+	double writerWait = 0;
+	double syncTime = 0;
 
-		//Write to output
-		output << minElement.value << "\n";
-		totalMerged++;
+	//Parallel final merge, unless the parts would be too small to pay off
+	size_t mergeThreads = 1;
+	if (options.mergeThreads > 1) {
+		uint64_t worthwhile = std::max<uint64_t>(last.elements / MIN_PARALLEL_MERGE, 1);
+		mergeThreads = static_cast<size_t>(std::min<uint64_t>(options.mergeThreads, worthwhile));
 
-		//Progress indicator
-		if (totalMerged % progressInterval == 0) {
-			std::cout << "\nMerged: " << (totalMerged / 1000000.0) << " M elements..."
-				<< std::flush;
+		//Every part opens each run and its own output; the plan's fan-in
+		//only bounds one merge, so keep all parts within the fd limit
+		size_t fileLimit = chooseFanIn(SIZE_MAX, 1, 1, FileIO::maxOpenFiles());
+		size_t byFiles = std::max<size_t>(fileLimit / (files.size() + 1), 1);
+		if (byFiles < mergeThreads) {
+			std::cout << "Parallel merge limited to " << byFiles << " part(s) by the open file limit ("
+				<< files.size() << " runs each)\n";
+			mergeThreads = byFiles;
+		}
+	}
+	bool partitioned = mergeThreads > 1;
+	if (partitioned) {
+		//Every part brings its own blocks; free those of the intermediate merges
+		blockMemory.reset();
+		blockPool.reset(0, 0);
+		totalMerged = mergePartitioned(files, mergeThreads, syncTime);
+	}
+	else {
+		std::cout << "Opening chunk files...\n";
+		openRuns(files);
+		std::cout << "Read blocks: " << blockPool.getBlockCount() << " x " << formatSize(blockPool.getBlockBytes())
+			<< " (" << formatSize(blockPool.getBlockBytes() * blockPool.getBlockCount()) << ")"
+			<< (options.mergeReadAhead ? ", forecasting read-ahead" : "") << "\n";
+		std::cout << "All " << files.size() << " chunks opened\n";
+		std::cout << " Starting " << files.size() << "-wahy merge...\n";
+
+		MemoryReservation outputMemory(options.memory,
+			options.asyncOutput ? MemoryGovernor::ASYNC_WRITER_BYTES : MemoryGovernor::INT_WRITER_BYTES);
+		if (options.asyncOutput) {
+			AsyncIntWriter output(outputFilename, options.syncOutput);
+			totalMerged = mergeInto(output, true);
+			output.close();
+			writerWait = output.getWaitSeconds();
+			syncTime = output.getSyncSeconds();
+		}
+		else {
+			IntWriter output(outputFilename);
+			totalMerged = mergeInto(output, true);
+			if (options.syncOutput) {
+				Timer syncTimer;
+				output.sync();
+				syncTime = syncTimer.elapsed();
+			}
+			output.close();
 		}
-		//Read next element from same chunk
-		readNextFromChunk(minElement.chunkIndex);
 	}
 
 	//Cleanup
-	output.close();
-	closeAllChunks();
+	closeRuns();
+	removeIntermediates();
 
 	//Summary
 	setMergerColor(COLOR_GREEN);
@@ -132,6 +408,23 @@ void Merger::merge() {
 	std::cout << " Total elements Merged :" << totalMerged << "\n";
 	std::cout << " Output file :" << outputFilename << "\n";
 	std::cout << " Time: " << formatTime(timer.elapsed()) << "\n";
+	if (plan.getIntermediateMerges() > 0) {
+		std::cout << " Merge passes: " << plan.depth << ", rewrote " << formatSize(bytesRewritten)
+			<< " in intermediate runs (" << std::fixed << std::setprecision(2)
+			<< (1.0 + static_cast<double>(bytesRewritten) / std::max<uint64_t>(runBytes, 1))
+			<< std::defaultfloat << " passes over the data)\n";
+	}
+	std::cout << " Blocks read: " << blocksRead << ", stalled " << formatTime(stallSeconds)
+		<< " waiting on reads (" << stalls << " waits)\n";
+	if (partitioned) {
+		std::cout << " Output: " << mergeThreads << " merge threads, one key range each\n";
+	}
+	else if (options.asyncOutput) {
+		std::cout << " Output: writer thread, merge waited " << formatTime(writerWait) << " on it\n";
+	}
+	if (options.syncOutput) {
+		std::cout << " fdatasync: " << formatTime(syncTime) << "\n";
+	}
 
 	//calculate throughput
 	double seconds = timer.elapsed();
@@ -141,4 +434,4 @@ void Merger::merge() {
 			<< "elements/sec\n";
 	}
 	std::cout << "\n";
-}
\ No newline at end of file
+}
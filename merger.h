@@ -5,41 +5,54 @@
 #include <string>
 #include <vector>
 #include <fstream>
-#include <queue>
-
-//Element in merge heap
-struct MergeElement {
-	int value;
-	int chunkIndex;
-
-	//For min-heap comparison
-	bool operator > (const MergeElement& other) const {
-		return value > other.value;
-	}
-};
+#include <memory>
+#include "merge_inputs.h"
+#include "loser_tree.h"
+#include "block_pool.h"
+#include "sort_options.h"
+#include "merge_plan.h"
+#include "memory_governor.h"
 
 //Merger: K-way merge of sorted chunk files
 class Merger {
 private:
 	std::vector<std::string> chunkFilenames;
 	std::string outputFilename;
+	SortOptions options;
+
+	//Read blocks shared by the run readers, sized to the merge budget
+	BlockPool blockPool;
+	MemoryReservation blockMemory;
 
-	//File streams for each chunk
-	std::vector<std::ifstream> chunkStreams;
+	//Block cursors (and read-ahead thread) for each chunk
+	std::unique_ptr<MergeInputs> inputs;
 
-	//Min-heap for k-way merge
-	std::priority_queue<MergeElement,
-		std::vector<MergeElement>,
-		std::greater<MergeElement>> minHeap;
+	//Tournament tree for k-way merge (log K comparisons per element)
+	LoserTree tree;
+
+	//Schedule of the last merge() and what it cost
+	MergePlan plan;
+	std::vector<std::string> intermediateFiles;   //Written by this merger and not yet deleted
+	uint64_t bytesRewritten;
+
+	double stallSeconds;
+	size_t blocksRead;
+	size_t stalls;
 
 	//Helper functions
-	bool readNextFromChunk(int chunkIndex);
-	void openAllChunks();
-	void closeAllChunks();
+	template <typename Writer>
+	size_t mergeInto(Writer& output, bool showProgress);
+	std::string getIntermediateFilename(size_t runId) const;
+	std::string getSegmentFilename(size_t part) const;
+	size_t mergePartitioned(const std::vector<std::string>& files, size_t parts, double& syncTime);
+	void openRuns(const std::vector<std::string>& files);
+	void closeRuns();
+	void removeIntermediates();
 
 public:
 	//Constructor
-	Merger(const std::vector<std::string>& chunks, const std::string& output);
+	Merger(const std::vector<std::string>& chunks, const std::string& output,
+		const SortOptions& options = SortOptions());
 
 	//Destructor
 	~Merger();
@@ -47,8 +60,15 @@ public:
 	//Main operation: merge all chunks
 	void merge();
 
+	//Most runs one merge pass opens with these options
+	static size_t maxFanIn(const SortOptions& options);
+
 	//Getters
 	int getChunkCount() const { return chunkFilenames.size(); }
+	size_t getBlockSize() const { return blockPool.getBlockBytes(); }
+	double getStallSeconds() const { return stallSeconds; }
+	const MergePlan& getPlan() const { return plan; }
+	uint64_t getBytesRewritten() const { return bytesRewritten; }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include "natural_runs.h"
+#include <algorithm>
+#include <functional>
+#include <iterator>
+
+namespace {
+
+struct Run {
+	size_t start;
+	size_t length;
+};
+
+//Stable merge of the adjacent runs at stack[i] and stack[i + 1]
+void mergeAt(int* data, std::vector<Run>& stack, size_t i, std::vector<int>& scratch) {
+	Run& left = stack[i];
+	const Run& right = stack[i + 1];
+
+	//Only the shorter run is copied out, so scratch never exceeds half the
+	//chunk; the output never overtakes the run left in place
+	if (left.length <= right.length) {
+		scratch.assign(data + left.start, data + left.start + left.length);
+		std::merge(scratch.begin(), scratch.end(), data + right.start, data + right.start + right.length,
+			data + left.start);
+	}
+	else {
+		//Merge backwards from the end; ties take the right run first to stay stable
+		using Reverse = std::reverse_iterator<int*>;
+		scratch.assign(data + right.start, data + right.start + right.length);
+		std::merge(scratch.rbegin(), scratch.rend(),
+			Reverse(data + left.start + left.length), Reverse(data + left.start),
+			Reverse(data + right.start + right.length), std::greater<int>());
+	}
+
+	left.length += right.length;
+	stack.erase(stack.begin() + i + 1);
+}
+
+//Restore Timsort's invariants on the top of the run stack: every run is
+//longer than the two above it together, so merges stay balanced
+void collapse(int* data, std::vector<Run>& stack, std::vector<int>& scratch) {
+	while (stack.size() > 1) {
+		size_t n = stack.size() - 2;
+		if ((n > 0 && stack[n - 1].length <= stack[n].length + stack[n + 1].length) ||
+			(n > 1 && stack[n - 2].length <= stack[n - 1].length + stack[n].length)) {
+			if (stack[n - 1].length < stack[n + 1].length) n--;
+		}
+		else if (stack[n].length > stack[n + 1].length) {
+			break;
+		}
+		mergeAt(data, stack, n, scratch);
+	}
+}
+
+}
+
+NaturalOrder NaturalRunSort::sort(std::vector<int>& arr, std::vector<int>& scratch, size_t& runs,
+	size_t minAverageRun) {
+	size_t n = arr.size();
+	runs = n > 0 ? 1 : 0;
+	if (n < 2) return NaturalOrder::Ascending;
+
+	//More runs than this and merging them costs more than sorting
+	size_t maxRuns = std::max<size_t>(n / std::max<size_t>(minAverageRun, 1), 1);
+	int* data = arr.data();
+
+	std::vector<Run> stack;
+	bool reversed = false;
+	runs = 0;
+	for (size_t start = 0; start < n;) {
+		size_t end = start + 1;
+		if (end < n && data[end] < data[start]) {
+			//Equal ints are interchangeable, so ties may join a descending run
+			while (end < n && data[end] <= data[end - 1]) end++;
+			std::reverse(data + start, data + end);
+			reversed = true;
+		}
+		else {
+			while (end < n && data[end] >= data[end - 1]) end++;
+		}
+
+		if (++runs > maxRuns) return NaturalOrder::Unsorted;
+		stack.push_back(Run{ start, end - start });
+		collapse(data, stack, scratch);
+		start = end;
+	}
+
+	if (runs == 1) {
+		return reversed ? NaturalOrder::Descending : NaturalOrder::Ascending;
+	}
+	while (stack.size() > 1) {
+		size_t i = stack.size() - 2;
+		if (i > 0 && stack[i - 1].length < stack[i + 1].length) i--;
+		mergeAt(data, stack, i, scratch);
+	}
+	return NaturalOrder::Runs;
+}
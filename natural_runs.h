@@ -0,0 +1,37 @@
+#pragma once
+#ifndef NATURAL_RUNS_H
+#define NATURAL_RUNS_H
+
+#include <cstddef>
+#include <vector>
+
+// What NaturalRunSort found in a chunk
+enum class NaturalOrder {
+	Ascending,    // Already sorted: nothing to do
+	Descending,   // One non-ascending run: reversed in place
+	Runs,         // Few long runs: merged Timsort-style
+	Unsorted      // Too many short runs: left for the sort kernel
+};
+
+// Adaptive pre-pass for chunks that arrive (nearly) in order.
+//
+// One scan splits the chunk into maximal natural runs, non-descending or
+// non-ascending; descending runs are reversed in place (equal ints are
+// interchangeable, so this needs no stability care). If the runs average
+// at least minAverageRun elements, they are merged with Timsort's
+// run-stack rules (balanced merges, each through a scratch copy of the
+// shorter run, so scratch stays within half the chunk) in O(n log r) for
+// r runs. Otherwise the chunk is left unsorted, possibly with some runs
+// reversed, and the caller sorts it as usual.
+class NaturalRunSort {
+public:
+	// Default: runs must average 256 elements to be worth merging
+	static constexpr size_t DEFAULT_MIN_AVERAGE_RUN = 256;
+
+	// Sort arr if its natural runs allow it; runs is set to the number found
+	// (counting stops once the chunk is known to be Unsorted)
+	static NaturalOrder sort(std::vector<int>& arr, std::vector<int>& scratch, size_t& runs,
+		size_t minAverageRun = DEFAULT_MIN_AVERAGE_RUN);
+};
+
+#endif
@@ -0,0 +1,79 @@
+#include "radix_sort.h"
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+
+const int RADIX_BITS = 8;
+const int RADIX_BUCKETS = 1 << RADIX_BITS;
+const int RADIX_PASSES = 32 / RADIX_BITS;
+
+// Below this size the histogram setup costs more than it saves
+const size_t SMALL_SORT = 64;
+
+inline uint32_t radixKey(int value) {
+	return static_cast<uint32_t>(value) ^ 0x80000000u;
+}
+
+}
+
+void RadixSort::sort(std::vector<int>& arr, std::vector<int>& scratch) {
+	size_t n = arr.size();
+	if (n < SMALL_SORT) {
+		std::sort(arr.begin(), arr.end());
+		return;
+	}
+	//Exact size (capacity is kept) so a final swap leaves arr.size() intact
+	scratch.resize(n);
+
+	//All digit histograms in one read of the input
+	size_t counts[RADIX_PASSES][RADIX_BUCKETS];
+	std::memset(counts, 0, sizeof(counts));
+	for (size_t i = 0; i < n; i++) {
+		uint32_t key = radixKey(arr[i]);
+		for (int pass = 0; pass < RADIX_PASSES; pass++) {
+			counts[pass][(key >> (pass * RADIX_BITS)) & (RADIX_BUCKETS - 1)]++;
+		}
+	}
+
+	int* src = arr.data();
+	int* dst = scratch.data();
+	bool swapped = false;
+
+	for (int pass = 0; pass < RADIX_PASSES; pass++) {
+		size_t* count = counts[pass];
+		int shift = pass * RADIX_BITS;
+
+		//Every key shares this digit: the pass would be a plain copy
+		if (count[(radixKey(src[0]) >> shift) & (RADIX_BUCKETS - 1)] == n) {
+			continue;
+		}
+
+		//Exclusive prefix sum gives each bucket's first output slot
+		size_t offsets[RADIX_BUCKETS];
+		size_t sum = 0;
+		for (int b = 0; b < RADIX_BUCKETS; b++) {
+			offsets[b] = sum;
+			sum += count[b];
+		}
+
+		for (size_t i = 0; i < n; i++) {
+			int value = src[i];
+			dst[offsets[(radixKey(value) >> shift) & (RADIX_BUCKETS - 1)]++] = value;
+		}
+
+		std::swap(src, dst);
+		swapped = !swapped;
+	}
+
+	//Result ended in scratch: exchange buffers instead of copying back
+	if (swapped) {
+		arr.swap(scratch);
+	}
+}
+
+void RadixSort::sort(std::vector<int>& arr) {
+	std::vector<int> scratch;
+	sort(arr, scratch);
+}
@@ -0,0 +1,20 @@
+#pragma once
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+#include <vector>
+
+// LSD radix sort for 32-bit integer keys: 8-bit digits, sign bit flipped
+// so negative values order first. O(n) per pass, at most 4 passes, and
+// passes whose digit is constant across the input are skipped.
+class RadixSort {
+public:
+	// Sort ascending. scratch is grown to arr.size() and can be reused
+	// across calls; arr and scratch may be swapped internally.
+	static void sort(std::vector<int>& arr, std::vector<int>& scratch);
+
+	// Convenience overload with a temporary scratch buffer
+	static void sort(std::vector<int>& arr);
+};
+
+#endif
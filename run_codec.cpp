@@ -0,0 +1,253 @@
+#include "run_codec.h"
+#include "file_io.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RUN_CODEC_SSE2 1
+#endif
+
+namespace {
+
+const size_t LANES = 4;
+
+//Bits needed for the largest difference
+uint32_t bitWidth(uint32_t value) {
+	uint32_t bits = 0;
+	while (value != 0) {
+		bits++;
+		value >>= 1;
+	}
+	return bits;
+}
+
+//32-bit words each lane takes for `groups` values of `bits` bits
+size_t laneWords(size_t groups, uint32_t bits) {
+	return (groups * bits + 31) / 32;
+}
+
+//Unpack one group of four differences (one per lane) at bit `offset`
+//of every lane; the scalar twin of the SSE2 loop below
+inline void unpackGroup(const uint32_t* words, size_t offset, uint32_t bits, uint32_t mask, uint32_t* out) {
+	size_t word = offset / 32;
+	uint32_t shift = static_cast<uint32_t>(offset % 32);
+	for (size_t lane = 0; lane < LANES; lane++) {
+		uint64_t pair = words[word * LANES + lane];
+		if (shift + bits > 32) {
+			pair |= static_cast<uint64_t>(words[(word + 1) * LANES + lane]) << 32;
+		}
+		out[lane] = static_cast<uint32_t>(pair >> shift) & mask;
+	}
+}
+
+}
+
+size_t packedPayloadBytes(size_t count, uint32_t bits) {
+	size_t groups = (count + LANES - 1) / LANES;
+	return laneWords(groups, bits) * LANES * sizeof(uint32_t);
+}
+
+void encodeFrame(const int* values, size_t count, std::vector<uint8_t>& out) {
+	//Differences as unsigned 32-bit numbers; they wrap for unsorted input
+	uint32_t deltas[RUN_FRAME_VALUES];
+	uint32_t largest = 0;
+	deltas[0] = 0;
+	for (size_t i = 1; i < count; i++) {
+		deltas[i] = static_cast<uint32_t>(values[i]) - static_cast<uint32_t>(values[i - 1]);
+		largest = std::max(largest, deltas[i]);
+	}
+
+	FrameHeader header;
+	header.first = count > 0 ? values[0] : 0;
+	header.count = static_cast<uint32_t>(count);
+	header.bits = bitWidth(largest);
+	header.reserved = 0;
+
+	size_t groups = (count + LANES - 1) / LANES;
+	size_t words = laneWords(groups, header.bits);
+	std::vector<uint32_t> payload(words * LANES, 0);
+
+	//Group j of every lane sits at bit j * bits of that lane's words
+	for (size_t i = 0; i < count && header.bits > 0; i++) {
+		size_t lane = i % LANES;
+		size_t offset = (i / LANES) * header.bits;
+		size_t word = offset / 32;
+		uint32_t shift = static_cast<uint32_t>(offset % 32);
+		uint64_t bitsAt = static_cast<uint64_t>(deltas[i]) << shift;
+		payload[word * LANES + lane] |= static_cast<uint32_t>(bitsAt);
+		if (shift + header.bits > 32) {
+			payload[(word + 1) * LANES + lane] |= static_cast<uint32_t>(bitsAt >> 32);
+		}
+	}
+
+	size_t start = out.size();
+	out.resize(start + sizeof(header) + payload.size() * sizeof(uint32_t));
+	std::memcpy(out.data() + start, &header, sizeof(header));
+	if (!payload.empty()) {
+		std::memcpy(out.data() + start + sizeof(header), payload.data(), payload.size() * sizeof(uint32_t));
+	}
+}
+
+void decodeFrame(const FrameHeader& header, const uint8_t* payload, int* dst) {
+	size_t count = header.count;
+	uint32_t bits = header.bits;
+	uint32_t mask = bits >= 32 ? 0xFFFFFFFFu : (1u << bits) - 1;
+	size_t fullGroups = count / LANES;
+	size_t groups = (count + LANES - 1) / LANES;
+	size_t group = 0;
+
+	//The payload may not be 4-byte aligned in the read buffer
+	const uint32_t* words = reinterpret_cast<const uint32_t*>(payload);
+	std::vector<uint32_t> aligned;
+	if (reinterpret_cast<uintptr_t>(payload) % alignof(uint32_t) != 0) {
+		aligned.resize(laneWords(groups, bits) * LANES);
+		std::memcpy(aligned.data(), payload, aligned.size() * sizeof(uint32_t));
+		words = aligned.data();
+	}
+
+#ifdef RUN_CODEC_SSE2
+	//Four lanes at once: one shift (plus the next word's low bits when a
+	//difference straddles two words) and a mask unpack a whole group, then
+	//a 4-wide prefix sum adds the running value
+	if (bits > 0) {
+		const __m128i* in = reinterpret_cast<const __m128i*>(words);
+		__m128i vmask = _mm_set1_epi32(static_cast<int>(mask));
+		__m128i current = _mm_loadu_si128(in++);
+		__m128i carry = _mm_set1_epi32(header.first);
+		uint32_t shift = 0;
+		for (; group < fullGroups; group++) {
+			__m128i x = _mm_srl_epi32(current, _mm_cvtsi32_si128(static_cast<int>(shift)));
+			shift += bits;
+			if (shift > 32) {
+				current = _mm_loadu_si128(in++);
+				shift -= 32;
+				x = _mm_or_si128(x, _mm_sll_epi32(current, _mm_cvtsi32_si128(static_cast<int>(bits - shift))));
+			}
+			else if (shift == 32 && group + 1 < groups) {
+				current = _mm_loadu_si128(in++);
+				shift = 0;
+			}
+			x = _mm_and_si128(x, vmask);
+
+			x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+			x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+			x = _mm_add_epi32(x, carry);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + group * LANES), x);
+			carry = _mm_shuffle_epi32(x, 0xFF);
+		}
+	}
+#endif
+
+	//Scalar path: the remaining groups (all of them without SSE2)
+	uint32_t running = static_cast<uint32_t>(group > 0 ? dst[group * LANES - 1] : header.first);
+	for (; group < groups; group++) {
+		uint32_t deltas[LANES] = { 0, 0, 0, 0 };
+		if (bits > 0) unpackGroup(words, group * bits, bits, mask, deltas);
+		for (size_t lane = 0; lane < LANES; lane++) {
+			size_t i = group * LANES + lane;
+			if (i >= count) break;
+			running += deltas[lane];
+			dst[i] = static_cast<int>(running);
+		}
+	}
+
+	//All differences zero: the SSE2 loop was skipped, fill in the values
+	if (bits == 0) {
+		std::fill(dst, dst + count, header.first);
+	}
+}
+
+// ---------------- PackedRunReader ----------------
+
+PackedRunReader::PackedRunReader(std::FILE* f, const std::string& name, uint64_t values)
+	: file(f), filename(name), count(values), remaining(values), input(READ_BYTES), inputPos(0), inputEnd(0),
+	frame(RUN_FRAME_VALUES), framePos(0), frameEnd(0) {
+}
+
+//Make `bytes` compressed bytes available at the read position
+const uint8_t* PackedRunReader::fetch(size_t bytes) {
+	if (inputEnd - inputPos < bytes) {
+		std::memmove(input.data(), input.data() + inputPos, inputEnd - inputPos);
+		inputEnd -= inputPos;
+		inputPos = 0;
+		if (input.size() < bytes) input.resize(bytes);
+		inputEnd += std::fread(input.data() + inputEnd, 1, input.size() - inputEnd, file);
+		if (inputEnd < bytes) {
+			throw std::runtime_error("Truncated run file: " + filename);
+		}
+	}
+	const uint8_t* data = input.data() + inputPos;
+	inputPos += bytes;
+	return data;
+}
+
+//Decode the next frame to dst; returns its value count
+size_t PackedRunReader::decodeNext(int* dst) {
+	FrameHeader header;
+	std::memcpy(&header, fetch(sizeof(header)), sizeof(header));
+	size_t expected = static_cast<size_t>(std::min<uint64_t>(remaining, RUN_FRAME_VALUES));
+	if (header.count != expected || header.bits > 32) {
+		throw std::runtime_error("Corrupt run frame: " + filename);
+	}
+	decodeFrame(header, fetch(packedPayloadBytes(header.count, header.bits)), dst);
+	remaining -= header.count;
+	return header.count;
+}
+
+void PackedRunReader::seek(uint64_t index) {
+	uint64_t frames = (count + RUN_FRAME_VALUES - 1) / RUN_FRAME_VALUES;
+	if (frameOffsets.empty() && frames > 0) {
+		//The last 8 bytes locate the frame index
+		uint64_t fileBytes = FileIO::getFileSize(filename);
+		uint64_t indexOffset = 0;
+		frameOffsets.resize(static_cast<size_t>(frames));
+		if (fileBytes < sizeof(uint64_t) || !FileIO::seek(file, fileBytes - sizeof(uint64_t)) ||
+			std::fread(&indexOffset, sizeof(indexOffset), 1, file) != 1 ||
+			!FileIO::seek(file, indexOffset) ||
+			std::fread(frameOffsets.data(), sizeof(uint64_t), frameOffsets.size(), file) != frameOffsets.size()) {
+			frameOffsets.clear();
+			throw std::runtime_error("Cannot read frame index: " + filename);
+		}
+	}
+
+	inputPos = inputEnd = 0;
+	framePos = frameEnd = 0;
+	if (index >= count) {
+		remaining = 0;
+		return;
+	}
+	uint64_t frameIndex = index / RUN_FRAME_VALUES;
+	if (!FileIO::seek(file, frameOffsets[static_cast<size_t>(frameIndex)])) {
+		throw std::runtime_error("Cannot seek run file: " + filename);
+	}
+	remaining = count - frameIndex * RUN_FRAME_VALUES;
+	frameEnd = decodeNext(frame.data());
+	framePos = static_cast<size_t>(index % RUN_FRAME_VALUES);
+}
+
+size_t PackedRunReader::read(int* dst, size_t maxCount) {
+	size_t total = 0;
+	while (total < maxCount) {
+		//Left over from a frame that did not fit last time
+		if (framePos < frameEnd) {
+			size_t n = std::min(maxCount - total, frameEnd - framePos);
+			std::copy(frame.data() + framePos, frame.data() + framePos + n, dst + total);
+			framePos += n;
+			total += n;
+			continue;
+		}
+		if (remaining == 0) break;
+
+		size_t next = static_cast<size_t>(std::min<uint64_t>(remaining, RUN_FRAME_VALUES));
+		if (maxCount - total >= next) {
+			total += decodeNext(dst + total);
+		}
+		else {
+			frameEnd = decodeNext(frame.data());
+			framePos = 0;
+		}
+	}
+	return total;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#ifndef RUN_CODEC_H
+#define RUN_CODEC_H
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Delta + bit-packed frame-of-reference codec for sorted runs.
+//
+// A packed run stores its values in frames of RUN_FRAME_VALUES (the last
+// one shorter). Each frame keeps its first value and the differences
+// between neighbours, which in a sorted run are small and non-negative,
+// packed with the bit width of the frame's largest difference. The
+// differences are dealt out to four lanes (value i to lane i % 4) and the
+// lanes' 32-bit words interleaved, so SSE2 unpacks four values with one
+// shift and mask and a prefix sum turns them back into values. Unsorted
+// data still round-trips, the differences just need more bits.
+//
+// File layout (after the RunHeader, elementType Int32Packed):
+//   [FrameHeader][payload] x frames
+//   [uint64 frame offset] x frames    // Random access to frame k
+//   [uint64 offset of the frame index]
+
+const size_t RUN_FRAME_VALUES = 1024;
+
+struct FrameHeader {
+	int32_t first;       // First value of the frame
+	uint32_t count;      // Values in the frame
+	uint32_t bits;       // Width of every packed difference (0-32)
+	uint32_t reserved;
+};
+static_assert(sizeof(FrameHeader) == 16, "FrameHeader must stay 16 bytes on disk");
+
+// Payload bytes of a frame of `count` values packed with `bits` bits
+size_t packedPayloadBytes(size_t count, uint32_t bits);
+
+// Append one frame (header and payload) of count <= RUN_FRAME_VALUES values
+void encodeFrame(const int* values, size_t count, std::vector<uint8_t>& out);
+
+// Decode a frame's payload into exactly header.count values at dst
+void decodeFrame(const FrameHeader& header, const uint8_t* payload, int* dst);
+
+// Sequential reader of a packed run's values, from an open file
+// positioned at its first frame. Compressed bytes are read in large
+// blocks, and whole frames are decoded straight into the caller's buffer
+// whenever they fit.
+class PackedRunReader {
+private:
+	std::FILE* file;             // Not owned
+	std::string filename;
+	uint64_t count;              // Values in the whole run
+	uint64_t remaining;          // Values from the current frame on, not yet decoded
+	std::vector<uint8_t> input;  // Compressed bytes read ahead
+	size_t inputPos;
+	size_t inputEnd;
+	std::vector<int> frame;      // A frame that did not fit the caller's buffer
+	size_t framePos;
+	size_t frameEnd;
+	std::vector<uint64_t> frameOffsets;   // Loaded on the first seek
+
+	const uint8_t* fetch(size_t bytes);
+	size_t decodeNext(int* dst);
+
+public:
+	// Compressed bytes read per fread (at least one whole frame)
+	static constexpr size_t READ_BYTES = 16 * 1024;
+
+	PackedRunReader(std::FILE* file, const std::string& filename, uint64_t count);
+
+	// Continue from value `index` of the run (loads the frame index)
+	void seek(uint64_t index);
+
+	// Decode up to maxCount values; returns the number decoded
+	size_t read(int* dst, size_t maxCount);
+};
+
+#endif
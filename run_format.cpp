@@ -0,0 +1,264 @@
+#include "run_format.h"
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+
+RunHeader readRunHeader(std::FILE* file, const std::string& filename) {
+	RunHeader header;
+	if (std::fread(&header, sizeof(header), 1, file) != 1) {
+		throw std::runtime_error("Truncated run header: " + filename);
+	}
+	if (header.magic != RUN_MAGIC || header.version != RUN_VERSION ||
+		(header.elementType != static_cast<uint16_t>(RunElementType::Int32) && !isPackedRun(header))) {
+		throw std::runtime_error("Not a valid run file: " + filename);
+	}
+	return header;
+}
+
+// ---------------- RunWriter ----------------
+
+RunWriter::RunWriter(const std::string& name, size_t bufferInts, bool packedRun)
+	: file(nullptr), filename(name), buffer(bufferInts > 0 ? bufferInts : 1), buffered(0), packed(packedRun),
+	bytesWritten(0) {
+	header.magic = RUN_MAGIC;
+	header.version = RUN_VERSION;
+	header.elementType = static_cast<uint16_t>(packed ? RunElementType::Int32Packed : RunElementType::Int32);
+	header.count = 0;
+	header.minValue = INT_MAX;
+	header.maxValue = INT_MIN;
+
+	file = std::fopen(filename.c_str(), "wb");
+	if (!file) {
+		throw std::runtime_error("Cannot create run file: " + filename);
+	}
+
+	//Reserve space for the header, rewritten on close
+	if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+		std::fclose(file);
+		file = nullptr;
+		throw std::runtime_error("Cannot write run header: " + filename);
+	}
+	bytesWritten = sizeof(header);
+
+	//Packed runs encode whole frames, so the buffer holds whole frames
+	if (packed) {
+		size_t frames = (buffer.size() + RUN_FRAME_VALUES - 1) / RUN_FRAME_VALUES;
+		buffer.resize(frames * RUN_FRAME_VALUES);
+	}
+}
+
+RunWriter::~RunWriter() {
+	if (file) {
+		try {
+			close();
+		}
+		catch (...) {
+			//Never throw from destructor
+		}
+	}
+}
+
+void RunWriter::writeBytes(const void* data, size_t bytes) {
+	if (bytes > 0 && std::fwrite(data, 1, bytes, file) != bytes) {
+		throw std::runtime_error("Failed writing run file: " + filename);
+	}
+	bytesWritten += bytes;
+}
+
+void RunWriter::flushBuffer() {
+	if (packed) {
+		flushFrames(false);
+		return;
+	}
+	writeBytes(buffer.data(), buffered * sizeof(int));
+	buffered = 0;
+}
+
+//Encode the buffered whole frames (and the partial last one if final)
+void RunWriter::flushFrames(bool final) {
+	size_t frames = final ? (buffered + RUN_FRAME_VALUES - 1) / RUN_FRAME_VALUES : buffered / RUN_FRAME_VALUES;
+	encoded.clear();
+	size_t done = 0;
+	for (size_t f = 0; f < frames; f++) {
+		size_t n = std::min(RUN_FRAME_VALUES, buffered - done);
+		frameOffsets.push_back(bytesWritten + encoded.size());
+		encodeFrame(buffer.data() + done, n, encoded);
+		done += n;
+	}
+	writeBytes(encoded.data(), encoded.size());
+	std::copy(buffer.begin() + done, buffer.begin() + buffered, buffer.begin());
+	buffered -= done;
+}
+
+void RunWriter::write(int value) {
+	if (buffered == buffer.size()) {
+		flushBuffer();
+	}
+	buffer[buffered++] = value;
+	header.minValue = std::min(header.minValue, value);
+	header.maxValue = std::max(header.maxValue, value);
+	header.count++;
+}
+
+void RunWriter::write(const int* values, size_t count) {
+	if (count == 0) return;
+
+	for (size_t i = 0; i < count; i++) {
+		header.minValue = std::min(header.minValue, values[i]);
+		header.maxValue = std::max(header.maxValue, values[i]);
+	}
+	header.count += count;
+
+	//Packed runs go through the buffer a frame at a time
+	if (packed) {
+		while (count > 0) {
+			size_t n = std::min(count, buffer.size() - buffered);
+			std::copy(values, values + n, buffer.begin() + buffered);
+			buffered += n;
+			values += n;
+			count -= n;
+			if (buffered == buffer.size()) flushBuffer();
+		}
+		return;
+	}
+
+	//Large blocks bypass the staging buffer
+	if (count >= buffer.size()) {
+		flushBuffer();
+		writeBytes(values, count * sizeof(int));
+		return;
+	}
+
+	if (buffered + count > buffer.size()) {
+		flushBuffer();
+	}
+	std::copy(values, values + count, buffer.begin() + buffered);
+	buffered += count;
+}
+
+void RunWriter::close() {
+	if (!file) return;
+
+	try {
+		if (packed) {
+			//Last frame, the frame index, then where the index starts
+			flushFrames(true);
+			uint64_t indexOffset = bytesWritten;
+			writeBytes(frameOffsets.data(), frameOffsets.size() * sizeof(uint64_t));
+			writeBytes(&indexOffset, sizeof(indexOffset));
+		}
+		else {
+			flushBuffer();
+		}
+	}
+	catch (...) {
+		std::fclose(file);
+		file = nullptr;
+		throw;
+	}
+
+	std::FILE* f = file;
+	file = nullptr;
+
+	//Patch final count and min/max into the header
+	if (std::fseek(f, 0, SEEK_SET) != 0 ||
+		std::fwrite(&header, sizeof(header), 1, f) != 1) {
+		std::fclose(f);
+		throw std::runtime_error("Failed writing run header: " + filename);
+	}
+
+	if (std::fclose(f) != 0) {
+		throw std::runtime_error("Failed closing run file: " + filename);
+	}
+}
+
+// ---------------- RunReader ----------------
+
+RunReader::RunReader(size_t bufferInts)
+	: file(nullptr), ownedBuffer(bufferInts > 0 ? bufferInts : 1), position(0), available(0), remaining(0), header() {
+	block = ownedBuffer.data();
+	blockInts = ownedBuffer.size();
+}
+
+RunReader::RunReader(const std::string& name, size_t bufferInts)
+	: RunReader(bufferInts) {
+	open(name);
+}
+
+RunReader::RunReader(const std::string& name, int* externalBlock, size_t externalInts)
+	: file(nullptr), block(externalBlock), blockInts(externalInts), position(0), available(0), remaining(0), header() {
+	if (!block || blockInts == 0) {
+		throw std::invalid_argument("RunReader needs a non-empty block");
+	}
+	open(name);
+}
+
+RunReader::~RunReader() {
+	close();
+}
+
+void RunReader::open(const std::string& name) {
+	close();
+	filename = name;
+
+	file = std::fopen(filename.c_str(), "rb");
+	if (!file) {
+		throw std::runtime_error("Cannot open run file: " + filename);
+	}
+	//Reads are whole blocks: skip the stdio buffer and its extra copy
+	std::setvbuf(file, nullptr, _IONBF, 0);
+
+	try {
+		header = readRunHeader(file, filename);
+	}
+	catch (...) {
+		close();
+		throw;
+	}
+
+	remaining = header.count;
+	position = 0;
+	available = 0;
+	if (isPackedRun(header)) {
+		packed.reset(new PackedRunReader(file, filename, header.count));
+	}
+}
+
+void RunReader::close() {
+	packed.reset();
+	if (file) {
+		std::fclose(file);
+		file = nullptr;
+	}
+	position = 0;
+	available = 0;
+	remaining = 0;
+}
+
+bool RunReader::refill() {
+	if (!file || remaining == 0) return false;
+
+	size_t want = static_cast<size_t>(std::min<uint64_t>(remaining, blockInts));
+	size_t got = packed ? packed->read(block, want) : std::fread(block, sizeof(int), want, file);
+	if (got != want) {
+		throw std::runtime_error("Truncated run file: " + filename);
+	}
+
+	remaining -= got;
+	position = 0;
+	available = got;
+	return true;
+}
+
+size_t RunReader::read(int* dst, size_t maxCount) {
+	size_t total = 0;
+	while (total < maxCount) {
+		if (position == available && !refill()) break;
+
+		size_t n = std::min(maxCount - total, available - position);
+		std::copy(block + position, block + position + n, dst + total);
+		position += n;
+		total += n;
+	}
+	return total;
+}
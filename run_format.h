@@ -0,0 +1,124 @@
+#pragma once
+#ifndef RUN_FORMAT_H
+#define RUN_FORMAT_H
+
+#include <cstdio>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "run_codec.h"
+
+// Binary format for the intermediate sorted runs (temp chunk files).
+// Only the user-facing input and output files are text; runs are raw
+// int32 values behind a small fixed-size header so Chunker and Merger
+// never format or parse the data a second time.
+//
+// Layout (host byte order, runs never leave the machine that wrote them):
+//   [RunHeader][int32 value] x count
+// or, for packed runs, [RunHeader][frames...] as described in run_codec.h
+
+const uint32_t RUN_MAGIC = 0x4E555253; // "SRUN"
+const uint16_t RUN_VERSION = 1;
+
+enum class RunElementType : uint16_t {
+	Int32 = 1,
+	Int32Packed = 2     // Delta + bit-packed frames (run_codec.h)
+};
+
+struct RunHeader {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t elementType;
+	uint64_t count;      // Number of elements in the run
+	int32_t minValue;    // Smallest element (undefined when count == 0)
+	int32_t maxValue;    // Largest element (undefined when count == 0)
+};
+static_assert(sizeof(RunHeader) == 24, "RunHeader must stay 24 bytes on disk");
+
+// Read and validate the header at the start of an open run file (throws)
+RunHeader readRunHeader(std::FILE* file, const std::string& filename);
+
+inline bool isPackedRun(const RunHeader& header) {
+	return header.elementType == static_cast<uint16_t>(RunElementType::Int32Packed);
+}
+
+// Writes a sorted run. The header is patched in on close(), so runs of
+// unknown length can be streamed. Packed runs are encoded a frame at a
+// time as the buffer fills.
+class RunWriter {
+private:
+	std::FILE* file;
+	std::string filename;
+	std::vector<int> buffer;
+	size_t buffered;
+	RunHeader header;
+	bool packed;
+	std::vector<uint8_t> encoded;         // Frames of the last flush
+	std::vector<uint64_t> frameOffsets;   // Packed runs: where each frame starts
+	uint64_t bytesWritten;                // Since the start of the file
+
+	void flushBuffer();
+	void flushFrames(bool final);
+	void writeBytes(const void* data, size_t bytes);
+
+public:
+	explicit RunWriter(const std::string& filename, size_t bufferInts = 64 * 1024, bool packed = false);
+	~RunWriter();
+
+	RunWriter(const RunWriter&) = delete;
+	RunWriter& operator=(const RunWriter&) = delete;
+
+	void write(int value);
+	void write(const int* values, size_t count);
+	void close();
+
+	uint64_t getCount() const { return header.count; }
+	uint64_t getBytesWritten() const { return bytesWritten; }   // Valid after close()
+};
+
+// Reads a run written by RunWriter, buffered in blocks. The block is
+// either owned by the reader or lent by the caller (e.g. from a BlockPool).
+class RunReader {
+private:
+	std::FILE* file;
+	std::string filename;
+	std::vector<int> ownedBuffer;
+	int* block;
+	size_t blockInts;
+	size_t position;
+	size_t available;
+	uint64_t remaining;
+	RunHeader header;
+	std::unique_ptr<PackedRunReader> packed;
+
+	bool refill();
+
+public:
+	explicit RunReader(size_t bufferInts = 16 * 1024);
+	explicit RunReader(const std::string& filename, size_t bufferInts = 16 * 1024);
+	// Read through a caller-owned block of blockInts ints; it must outlive the reader
+	RunReader(const std::string& filename, int* block, size_t blockInts);
+	~RunReader();
+
+	RunReader(const RunReader&) = delete;
+	RunReader& operator=(const RunReader&) = delete;
+
+	void open(const std::string& filename);
+	bool isOpen() const { return file != nullptr; }
+	void close();
+
+	// Read next value; returns false at end of run
+	bool next(int& value) {
+		if (position == available && !refill()) return false;
+		value = block[position++];
+		return true;
+	}
+
+	// Bulk read up to maxCount values; returns number read
+	size_t read(int* dst, size_t maxCount);
+
+	const RunHeader& getHeader() const { return header; }
+};
+
+#endif
@@ -0,0 +1,147 @@
+#pragma once
+#ifndef SORT_OPTIONS_H
+#define SORT_OPTIONS_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class MemoryGovernor;
+class TempFiles;
+class BufferPool;
+
+// How Chunker turns the input into sorted runs
+enum class RunGeneration {
+	FixedChunks,            // Read maxIntegers values, sort, spill
+	ReplacementSelection    // Stream through a min-heap; runs average ~2x memory
+};
+
+// In-memory sort used for each chunk (see sort_strategy.h)
+enum class SortAlgorithm {
+	HeapSort,           // Heap::heapSort, O(n log n) worst case
+	IntroSort,          // std::sort
+	PdqSort,            // Pattern-defeating quicksort
+	RadixSort,          // LSD radix sort, O(n) for 32-bit keys
+	ParallelSampleSort  // Sample sort across threadCount threads
+};
+
+// How the chunking phase reads the input file
+enum class InputMode {
+	Stream,   // Read blocks into a buffer (FileBlockSource)
+	Mapped    // Parse straight from mmap'd windows (MappedBlockSource)
+};
+
+// How Sorter orders the whole file
+enum class SortMode {
+	MergeRuns,      // Sorted runs, then a K-way merge (Chunker + Merger)
+	Distribution    // Sampled buckets sorted in memory and concatenated (Distributor)
+};
+
+// Which temp directory a new temp file goes to (see temp_files.h)
+enum class TempPlacement {
+	RoundRobin,   // Take the directories in turn
+	FreeSpace     // The volume with the most free space at the time
+};
+
+// Tuning knobs shared by Sorter, Chunker, Merger and Distributor.
+// Defaults reproduce the original single-threaded merge sort, except
+// that Sorter first tries the counting sort (countingSort) and the
+// in-memory path (inMemory); both produce the same output.
+struct SortOptions {
+	// Overall algorithm
+	SortMode sortMode = SortMode::MergeRuns;
+
+	// Let Sorter pick chunk size, chunk sort, run generation and fan-in
+	// from a sample of the input (overrides those settings)
+	bool autoPlan = false;
+
+	// Sort in one counting pass when a sample shows a value range whose
+	// histogram fits in memory (falls back to sortMode otherwise)
+	bool countingSort = true;
+
+	// Sort inputs that fit the memory budget in memory, with no temp
+	// files (budget: memoryBudget, else the chunking memory plus the
+	// reader and writer buffers)
+	bool inMemory = true;
+
+	// Buckets for the distribution sort (0 = about half a chunk each)
+	size_t bucketCount = 0;
+
+	// Bytes for the whole sort (0 = no overall budget): Sorter splits it
+	// between the phases and overrides the chunk size and both phase budgets
+	size_t memoryBudget = 0;
+
+	// Governor tracking allocations against memoryBudget; set by Sorter
+	// (not owned, null when there is no budget)
+	MemoryGovernor* memory = nullptr;
+
+	// Back new large buffers with transparent huge pages (MADV_HUGEPAGE)
+	bool hugePages = false;
+
+	// Job-wide pool recycling chunk, scratch, bucket and read block
+	// buffers; set by Sorter (not owned, null = plain allocations)
+	BufferPool* buffers = nullptr;
+
+	// Worker threads sorting and spilling chunks (1 = sort on the reader thread)
+	int threadCount = 1;
+
+	// Bytes allowed for in-flight chunk buffers while chunking
+	// (0 = one buffer per worker plus one being filled)
+	size_t chunkMemoryBudget = 0;
+
+	// Run generation strategy for the chunking phase
+	RunGeneration runGeneration = RunGeneration::FixedChunks;
+
+	// Kernel used to sort each in-memory chunk
+	SortAlgorithm chunkSort = SortAlgorithm::HeapSort;
+
+	// Check each chunk for natural order first: sorted chunks are written
+	// as is, descending ones reversed, a few long runs merged
+	bool adaptiveChunks = true;
+
+	// Store sorted runs (chunks and intermediate merges) as delta +
+	// bit-packed frames instead of raw int32 (run_codec.h): several times
+	// less temp I/O for a little CPU
+	bool compressRuns = false;
+
+	// Directories for temp files (empty = the working directory); the
+	// job makes its own directory in each and spreads its files over them
+	std::vector<std::string> tempDirs;
+	TempPlacement tempPlacement = TempPlacement::RoundRobin;
+
+	// The job's temp file placement; set by Sorter (not owned, null =
+	// fixed names in the working directory)
+	TempFiles* temp = nullptr;
+
+	// Input reader for the chunking phase
+	InputMode inputMode = InputMode::Stream;
+
+	// Newline-aligned byte ranges parsed and chunked by their own thread
+	// (1 = one reader for the whole file)
+	int inputSplits = 1;
+
+	// Bytes for the merge phase's run read blocks (0 = 64 MB)
+	size_t mergeMemoryBudget = 0;
+
+	// Read block per run while merging (0 = chosen from run count and budget)
+	size_t mergeBlockSize = 0;
+
+	// Most runs merged at once (0 = from the merge budget and the fd limit);
+	// more runs than this are merged in several passes
+	size_t maxFanIn = 0;
+
+	// Threads for the final merge, each merging its own key range of every
+	// run (1 = single-threaded merge)
+	int mergeThreads = 1;
+
+	// Prefetch merge blocks on a background thread in forecast order
+	bool mergeReadAhead = true;
+
+	// Format and write the merged output on a writer thread
+	bool asyncOutput = true;
+
+	// fdatasync the output file before reporting success
+	bool syncOutput = false;
+};
+
+#endif
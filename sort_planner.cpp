@@ -0,0 +1,121 @@
+#include "sort_planner.h"
+#include "sort_strategy.h"
+#include "merger.h"
+#include "utils.h"
+#include <algorithm>
+#include <cmath>
+
+//Chunking memory when no budget is given
+static const size_t DEFAULT_PLAN_MEMORY = 256 * 1024 * 1024;
+
+//Chunk size limits; chunks are whole MB
+static const size_t MIN_PLAN_CHUNK = 1024 * 1024;
+
+//Below this many ints per chunk radix sort's passes do not pay off
+static const size_t MIN_RADIX_CHUNK = 64 * 1024;
+
+//Histogram memory the counting check accepts at least (see counting_sort.cpp)
+static const uint64_t COUNTING_RANGE = 64 * 1024 * 1024 / (sizeof(uint64_t) + sizeof(uint32_t));
+
+InputProfile profileInput(const InputSample& sample) {
+	InputProfile profile;
+	profile.fileBytes = sample.fileBytes;
+	profile.estimatedCount = sample.estimateCount();
+	profile.sampleSize = sample.values.size();
+	if (sample.values.empty()) return profile;
+
+	auto bounds = std::minmax_element(sample.values.begin(), sample.values.end());
+	profile.minValue = *bounds.first;
+	profile.maxValue = *bounds.second;
+
+	std::vector<int> sorted = sample.values;
+	std::sort(sorted.begin(), sorted.end());
+	size_t distinct = std::unique(sorted.begin(), sorted.end()) - sorted.begin();
+	profile.duplicateRatio = 1.0 - static_cast<double>(distinct) / sample.values.size();
+
+	//Order of neighbours inside each window; window edges are not neighbours
+	size_t pairs = 0, ascending = 0, descending = 0;
+	for (size_t w = 0; w < sample.windowStarts.size(); w++) {
+		size_t begin = sample.windowStarts[w];
+		size_t end = w + 1 < sample.windowStarts.size() ? sample.windowStarts[w + 1] : sample.values.size();
+		for (size_t i = begin + 1; i < end; i++) {
+			pairs++;
+			if (sample.values[i - 1] <= sample.values[i]) ascending++;
+			if (sample.values[i - 1] >= sample.values[i]) descending++;
+		}
+	}
+	if (pairs > 0) {
+		profile.ascendingRatio = static_cast<double>(ascending) / pairs;
+		profile.descendingRatio = static_cast<double>(descending) / pairs;
+	}
+	return profile;
+}
+
+SortPlan planSort(const InputProfile& profile, const SortOptions& options) {
+	SortPlan plan;
+	size_t threads = static_cast<size_t>(std::max(options.threadCount, 1));
+	double ordered = std::max(profile.ascendingRatio, profile.descendingRatio);
+
+	uint64_t range = static_cast<uint64_t>(static_cast<int64_t>(profile.maxValue) - profile.minValue) + 1;
+	plan.countingCandidate = options.countingSort && profile.sampleSize > 0 && range <= COUNTING_RANGE;
+	if (plan.countingCandidate) {
+		plan.reasons.push_back("value range " + std::to_string(range) + " fits a histogram: counting sort first");
+	}
+
+	//Run generation
+	if (ordered < 0.99 && profile.ascendingRatio >= 0.75 && threads == 1) {
+		plan.runGeneration = RunGeneration::ReplacementSelection;
+		plan.reasons.push_back("partly sorted input: replacement selection for runs longer than memory");
+	}
+
+	//Chunk size: the memory budget split over the buffers in flight,
+	//no larger than the input itself
+	size_t budget = options.chunkMemoryBudget > 0 ? options.chunkMemoryBudget : DEFAULT_PLAN_MEMORY;
+	size_t buffers = plan.runGeneration == RunGeneration::ReplacementSelection ? 1 : threads + 1;
+	uint64_t inputBytes = profile.estimatedCount * sizeof(int);
+	uint64_t chunk = std::min<uint64_t>(budget / buffers, inputBytes + MIN_PLAN_CHUNK);
+	chunk = std::max<uint64_t>(chunk / MIN_PLAN_CHUNK * MIN_PLAN_CHUNK, MIN_PLAN_CHUNK);
+	plan.chunkSize = static_cast<size_t>(chunk);
+	size_t chunkInts = plan.chunkSize / sizeof(int);
+
+	//Kernel
+	if (ordered >= 0.99) {
+		plan.kernel = SortAlgorithm::PdqSort;
+		plan.reasons.push_back("nearly sorted input: natural runs skip the kernel, pdq for the rest");
+	}
+	else if (profile.duplicateRatio >= 0.5) {
+		plan.kernel = SortAlgorithm::PdqSort;
+		plan.reasons.push_back("many duplicate keys: pdq sort");
+	}
+	else if (chunkInts >= MIN_RADIX_CHUNK) {
+		plan.kernel = SortAlgorithm::RadixSort;
+		plan.reasons.push_back("random keys in large chunks: radix sort");
+	}
+	else {
+		plan.kernel = SortAlgorithm::IntroSort;
+		plan.reasons.push_back("small chunks: introsort");
+	}
+
+	//Fan-in: equal merges per pass when one pass cannot take every run
+	uint64_t runLength = plan.runGeneration == RunGeneration::ReplacementSelection ? 2 * chunkInts : chunkInts;
+	plan.expectedRuns = std::max<uint64_t>((profile.estimatedCount + runLength - 1) / runLength, 1);
+	SortOptions mergeOptions = options;
+	mergeOptions.maxFanIn = 0;
+	size_t limit = Merger::maxFanIn(mergeOptions);
+	if (plan.expectedRuns > limit) {
+		plan.expectedPasses = static_cast<int>(std::ceil(std::log(static_cast<double>(plan.expectedRuns))
+			/ std::log(static_cast<double>(limit)) - 1e-9));
+		double balanced = std::pow(static_cast<double>(plan.expectedRuns), 1.0 / plan.expectedPasses);
+		plan.fanIn = std::min<size_t>(static_cast<size_t>(std::ceil(balanced)), limit);
+		plan.reasons.push_back(std::to_string(plan.expectedRuns) + " runs over fan-in limit " + std::to_string(limit)
+			+ ": " + std::to_string(plan.expectedPasses) + " balanced passes");
+	}
+	return plan;
+}
+
+void applyPlan(const SortPlan& plan, SortOptions& options, size_t& chunkSize) {
+	chunkSize = plan.chunkSize;
+	options.chunkSort = plan.kernel;
+	options.runGeneration = plan.runGeneration;
+	options.maxFanIn = plan.fanIn;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#ifndef SORT_PLANNER_H
+#define SORT_PLANNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "sort_options.h"
+#include "input_sample.h"
+
+// Shape of an input file, estimated from a sample
+struct InputProfile {
+	uint64_t fileBytes = 0;
+	uint64_t estimatedCount = 0;
+	size_t sampleSize = 0;
+	int minValue = 0;                // Sampled value range
+	int maxValue = 0;
+	double duplicateRatio = 0;       // 1 - distinct / sampled values
+	double ascendingRatio = 0;       // Adjacent sampled pairs in ascending order
+	double descendingRatio = 0;      // Adjacent sampled pairs in descending order
+};
+
+// Profile a sample; adjacent pairs are taken within each sample window
+InputProfile profileInput(const InputSample& sample);
+
+// What the planner chose, and why
+struct SortPlan {
+	size_t chunkSize = 0;            // Bytes per chunk
+	SortAlgorithm kernel = SortAlgorithm::HeapSort;
+	RunGeneration runGeneration = RunGeneration::FixedChunks;
+	size_t fanIn = 0;                // 0 = everything in one merge pass
+	uint64_t expectedRuns = 0;
+	int expectedPasses = 1;
+	bool countingCandidate = false;  // Narrow range: the counting check will likely take it
+	std::vector<std::string> reasons;
+};
+
+// Pick kernel, run generation, chunk size and fan-in for an input:
+//  - nearly sorted or reversed input keeps fixed chunks, which natural
+//    run detection writes without sorting; pdq handles the leftovers
+//  - partly sorted input on one thread uses replacement selection, whose
+//    runs grow far beyond memory on ordered data
+//  - many duplicates pick pdq (equal keys partition in linear time),
+//    otherwise radix sort for chunks big enough to amortise its passes
+//  - chunks take the chunking memory (options.chunkMemoryBudget, or
+//    256 MB) split over the threads, but no more than the input
+//  - fan-in stays automatic when one pass fits; otherwise it is lowered
+//    so every pass merges about the same number of runs
+SortPlan planSort(const InputProfile& profile, const SortOptions& options);
+
+// Apply a plan to the options and chunk size Sorter runs with
+void applyPlan(const SortPlan& plan, SortOptions& options, size_t& chunkSize);
+
+#endif
@@ -0,0 +1,434 @@
+#include "sort_strategy.h"
+#include "heap.h"
+#include "radix_sort.h"
+#include "buffer_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <thread>
+
+// ---------------- Pattern-defeating quicksort ----------------
+
+namespace {
+
+const ptrdiff_t INSERTION_SORT_THRESHOLD = 24;
+const ptrdiff_t NINTHER_THRESHOLD = 128;
+const ptrdiff_t PARTIAL_INSERTION_LIMIT = 8;
+
+void insertionSort(int* begin, int* end) {
+	if (begin == end) return;
+
+	for (int* cur = begin + 1; cur != end; ++cur) {
+		int* sift = cur;
+		int* sift1 = cur - 1;
+		if (*sift < *sift1) {
+			int tmp = *sift;
+			do {
+				*sift-- = *sift1;
+			} while (sift != begin && tmp < *--sift1);
+			*sift = tmp;
+		}
+	}
+}
+
+// Insertion sort without the bounds check: *(begin - 1) is a sentinel
+// no larger than any element in the range
+void unguardedInsertionSort(int* begin, int* end) {
+	if (begin == end) return;
+
+	for (int* cur = begin + 1; cur != end; ++cur) {
+		int* sift = cur;
+		int* sift1 = cur - 1;
+		if (*sift < *sift1) {
+			int tmp = *sift;
+			do {
+				*sift-- = *sift1;
+			} while (tmp < *--sift1);
+			*sift = tmp;
+		}
+	}
+}
+
+// Insertion sort that gives up after a few moves; true if range is sorted
+bool partialInsertionSort(int* begin, int* end) {
+	if (begin == end) return true;
+
+	ptrdiff_t moves = 0;
+	for (int* cur = begin + 1; cur != end; ++cur) {
+		int* sift = cur;
+		int* sift1 = cur - 1;
+		if (*sift < *sift1) {
+			int tmp = *sift;
+			do {
+				*sift-- = *sift1;
+			} while (sift != begin && tmp < *--sift1);
+			*sift = tmp;
+			moves += cur - sift;
+		}
+		if (moves > PARTIAL_INSERTION_LIMIT) return false;
+	}
+	return true;
+}
+
+inline void sort2(int* a, int* b) {
+	if (*b < *a) std::iter_swap(a, b);
+}
+
+inline void sort3(int* a, int* b, int* c) {
+	sort2(a, b);
+	sort2(b, c);
+	sort2(a, b);
+}
+
+// Partition around *begin with equal elements going right. Returns the
+// pivot's final position and whether no element had to move.
+std::pair<int*, bool> partitionRight(int* begin, int* end) {
+	int pivot = *begin;
+	int* first = begin;
+	int* last = end;
+
+	//Median-of-3 guarantees an element >= pivot, so this scan is bounded
+	while (*++first < pivot);
+
+	if (first - 1 == begin) {
+		while (first < last && !(*--last < pivot));
+	}
+	else {
+		while (!(*--last < pivot));
+	}
+
+	bool alreadyPartitioned = first >= last;
+	while (first < last) {
+		std::iter_swap(first, last);
+		while (*++first < pivot);
+		while (!(*--last < pivot));
+	}
+
+	int* pivotPos = first - 1;
+	*begin = *pivotPos;
+	*pivotPos = pivot;
+	return std::make_pair(pivotPos, alreadyPartitioned);
+}
+
+// Partition with equal elements going left. Used when the pivot equals
+// the previous pivot, which puts a whole run of duplicates in place.
+int* partitionLeft(int* begin, int* end) {
+	int pivot = *begin;
+	int* first = begin;
+	int* last = end;
+
+	while (pivot < *--last);
+
+	if (last + 1 == end) {
+		while (first < last && !(pivot < *++first));
+	}
+	else {
+		while (!(pivot < *++first));
+	}
+
+	while (first < last) {
+		std::iter_swap(first, last);
+		while (pivot < *--last);
+		while (!(pivot < *++first));
+	}
+
+	int* pivotPos = last;
+	*begin = *pivotPos;
+	*pivotPos = pivot;
+	return pivotPos;
+}
+
+void pdqLoop(int* begin, int* end, int badAllowed, bool leftmost) {
+	for (;;) {
+		ptrdiff_t size = end - begin;
+
+		if (size < INSERTION_SORT_THRESHOLD) {
+			if (leftmost) {
+				insertionSort(begin, end);
+			}
+			else {
+				unguardedInsertionSort(begin, end);
+			}
+			return;
+		}
+
+		//Pivot: median of 3, or pseudo-median of 9 for large ranges
+		ptrdiff_t half = size / 2;
+		if (size > NINTHER_THRESHOLD) {
+			sort3(begin, begin + half, end - 1);
+			sort3(begin + 1, begin + (half - 1), end - 2);
+			sort3(begin + 2, begin + (half + 1), end - 3);
+			sort3(begin + (half - 1), begin + half, begin + (half + 1));
+			std::iter_swap(begin, begin + half);
+		}
+		else {
+			sort3(begin + half, begin, end - 1);
+		}
+
+		//Pivot equals the element left of the range: everything equal to it
+		//is already in its final place after a left partition
+		if (!leftmost && !(*(begin - 1) < *begin)) {
+			begin = partitionLeft(begin, end) + 1;
+			continue;
+		}
+
+		std::pair<int*, bool> part = partitionRight(begin, end);
+		int* pivotPos = part.first;
+		ptrdiff_t leftSize = pivotPos - begin;
+		ptrdiff_t rightSize = end - (pivotPos + 1);
+
+		if (leftSize < size / 8 || rightSize < size / 8) {
+			//Too many bad partitions: fall back to heap sort for O(n log n)
+			if (--badAllowed == 0) {
+				std::make_heap(begin, end);
+				std::sort_heap(begin, end);
+				return;
+			}
+
+			//Break up patterns that keep producing bad pivots
+			if (leftSize >= INSERTION_SORT_THRESHOLD) {
+				std::iter_swap(begin, begin + leftSize / 4);
+				std::iter_swap(pivotPos - 1, pivotPos - leftSize / 4);
+				if (leftSize > NINTHER_THRESHOLD) {
+					std::iter_swap(begin + 1, begin + (leftSize / 4 + 1));
+					std::iter_swap(begin + 2, begin + (leftSize / 4 + 2));
+					std::iter_swap(pivotPos - 2, pivotPos - (leftSize / 4 + 1));
+					std::iter_swap(pivotPos - 3, pivotPos - (leftSize / 4 + 2));
+				}
+			}
+			if (rightSize >= INSERTION_SORT_THRESHOLD) {
+				std::iter_swap(pivotPos + 1, pivotPos + (1 + rightSize / 4));
+				std::iter_swap(end - 1, end - rightSize / 4);
+				if (rightSize > NINTHER_THRESHOLD) {
+					std::iter_swap(pivotPos + 2, pivotPos + (2 + rightSize / 4));
+					std::iter_swap(pivotPos + 3, pivotPos + (3 + rightSize / 4));
+					std::iter_swap(end - 2, end - (1 + rightSize / 4));
+					std::iter_swap(end - 3, end - (2 + rightSize / 4));
+				}
+			}
+		}
+		else if (part.second
+			&& partialInsertionSort(begin, pivotPos)
+			&& partialInsertionSort(pivotPos + 1, end)) {
+			//Balanced, nothing moved and both sides nearly sorted: done
+			return;
+		}
+
+		//Recurse into the left part, loop on the right
+		pdqLoop(begin, pivotPos, badAllowed, leftmost);
+		begin = pivotPos + 1;
+		leftmost = false;
+	}
+}
+
+}
+
+void pdqSort(int* begin, int* end) {
+	ptrdiff_t size = end - begin;
+	if (size < 2) return;
+
+	int log2Size = 0;
+	while (size >>= 1) log2Size++;
+	pdqLoop(begin, end, log2Size, true);
+}
+
+// ---------------- Parallel sample sort ----------------
+
+namespace {
+
+// Below this size threads cost more than they save
+const size_t SAMPLE_SORT_MIN = 1 << 16;
+
+// Buckets per thread (more buckets = better load balance) and samples per bucket
+const size_t BUCKETS_PER_THREAD = 4;
+const size_t OVERSAMPLE = 64;
+
+template <typename Fn>
+void runOnThreads(size_t threads, Fn fn) {
+	std::vector<std::thread> pool;
+	for (size_t t = 1; t < threads; t++) {
+		pool.emplace_back(fn, t);
+	}
+	fn(0);
+	for (auto& thread : pool) {
+		thread.join();
+	}
+}
+
+}
+
+void parallelSampleSort(std::vector<int>& arr, std::vector<int>& scratch, int threadCount) {
+	size_t n = arr.size();
+	if (threadCount < 2 || n < SAMPLE_SORT_MIN) {
+		pdqSort(arr.data(), arr.data() + n);
+		return;
+	}
+
+	size_t threads = static_cast<size_t>(threadCount);
+	size_t buckets = threads * BUCKETS_PER_THREAD;
+
+	//Pick buckets-1 splitters from a sorted random sample
+	std::vector<int> sample(buckets * OVERSAMPLE);
+	std::mt19937 gen(static_cast<unsigned>(n));
+	std::uniform_int_distribution<size_t> pick(0, n - 1);
+	for (auto& s : sample) s = arr[pick(gen)];
+	std::sort(sample.begin(), sample.end());
+
+	std::vector<int> splitters(buckets - 1);
+	for (size_t b = 0; b + 1 < buckets; b++) {
+		splitters[b] = sample[(b + 1) * OVERSAMPLE];
+	}
+	auto bucketOf = [&](int value) {
+		return static_cast<size_t>(std::upper_bound(splitters.begin(), splitters.end(), value) - splitters.begin());
+	};
+
+	//Each thread counts its slice per bucket
+	std::vector<size_t> counts(threads * buckets, 0);
+	runOnThreads(threads, [&](size_t t) {
+		size_t* count = &counts[t * buckets];
+		for (size_t i = t * n / threads; i < (t + 1) * n / threads; i++) {
+			count[bucketOf(arr[i])]++;
+		}
+	});
+
+	//Bucket-major prefix sums: slice t of bucket b writes after slices < t
+	std::vector<size_t> bucketStart(buckets + 1, 0);
+	std::vector<size_t> offsets(threads * buckets);
+	size_t sum = 0;
+	for (size_t b = 0; b < buckets; b++) {
+		bucketStart[b] = sum;
+		for (size_t t = 0; t < threads; t++) {
+			offsets[t * buckets + b] = sum;
+			sum += counts[t * buckets + b];
+		}
+	}
+	bucketStart[buckets] = sum;
+
+	scratch.resize(n);
+	runOnThreads(threads, [&](size_t t) {
+		size_t* offset = &offsets[t * buckets];
+		for (size_t i = t * n / threads; i < (t + 1) * n / threads; i++) {
+			scratch[offset[bucketOf(arr[i])]++] = arr[i];
+		}
+	});
+
+	//Sort buckets, handing them out dynamically to balance skew
+	std::atomic<size_t> nextBucket(0);
+	runOnThreads(threads, [&](size_t) {
+		for (size_t b = nextBucket++; b < buckets; b = nextBucket++) {
+			pdqSort(scratch.data() + bucketStart[b], scratch.data() + bucketStart[b + 1]);
+		}
+	});
+
+	arr.swap(scratch);
+}
+
+// ---------------- Strategies ----------------
+
+namespace {
+
+class HeapSortStrategy : public ChunkSortStrategy {
+public:
+	void sort(std::vector<int>& chunk) override { Heap::heapSort(chunk); }
+	SortAlgorithm algorithm() const override { return SortAlgorithm::HeapSort; }
+};
+
+class IntroSortStrategy : public ChunkSortStrategy {
+public:
+	void sort(std::vector<int>& chunk) override { std::sort(chunk.begin(), chunk.end()); }
+	SortAlgorithm algorithm() const override { return SortAlgorithm::IntroSort; }
+};
+
+class PdqSortStrategy : public ChunkSortStrategy {
+public:
+	void sort(std::vector<int>& chunk) override { pdqSort(chunk.data(), chunk.data() + chunk.size()); }
+	SortAlgorithm algorithm() const override { return SortAlgorithm::PdqSort; }
+};
+
+//Take scratch for n values from the pool before the kernel grows it
+void poolScratch(BufferPool* buffers, std::vector<int>& scratch, size_t n) {
+	if (buffers && scratch.capacity() < n) {
+		buffers->give(scratch);
+		scratch = buffers->take(n);
+	}
+}
+
+class RadixSortStrategy : public ChunkSortStrategy {
+private:
+	std::vector<int> scratch;
+	BufferPool* buffers;
+
+public:
+	explicit RadixSortStrategy(BufferPool* buffers) : buffers(buffers) {}
+	~RadixSortStrategy() override { giveBuffer(buffers, scratch); }
+	void sort(std::vector<int>& chunk) override {
+		poolScratch(buffers, scratch, chunk.size());
+		RadixSort::sort(chunk, scratch);
+	}
+	SortAlgorithm algorithm() const override { return SortAlgorithm::RadixSort; }
+};
+
+class ParallelSampleSortStrategy : public ChunkSortStrategy {
+private:
+	std::vector<int> scratch;
+	int threads;
+	BufferPool* buffers;
+
+public:
+	ParallelSampleSortStrategy(int threads, BufferPool* buffers) : threads(threads), buffers(buffers) {}
+	~ParallelSampleSortStrategy() override { giveBuffer(buffers, scratch); }
+	void sort(std::vector<int>& chunk) override {
+		poolScratch(buffers, scratch, chunk.size());
+		parallelSampleSort(chunk, scratch, threads);
+	}
+	SortAlgorithm algorithm() const override { return SortAlgorithm::ParallelSampleSort; }
+};
+
+}
+
+std::unique_ptr<ChunkSortStrategy> makeSortStrategy(SortAlgorithm algorithm, int threads, BufferPool* buffers) {
+	switch (algorithm) {
+	case SortAlgorithm::IntroSort:
+		return std::unique_ptr<ChunkSortStrategy>(new IntroSortStrategy());
+	case SortAlgorithm::PdqSort:
+		return std::unique_ptr<ChunkSortStrategy>(new PdqSortStrategy());
+	case SortAlgorithm::RadixSort:
+		return std::unique_ptr<ChunkSortStrategy>(new RadixSortStrategy(buffers));
+	case SortAlgorithm::ParallelSampleSort:
+		return std::unique_ptr<ChunkSortStrategy>(new ParallelSampleSortStrategy(threads, buffers));
+	case SortAlgorithm::HeapSort:
+	default:
+		return std::unique_ptr<ChunkSortStrategy>(new HeapSortStrategy());
+	}
+}
+
+size_t sortScratchInts(SortAlgorithm algorithm, size_t n) {
+	switch (algorithm) {
+	case SortAlgorithm::RadixSort:
+	case SortAlgorithm::ParallelSampleSort:
+		return n;
+	default:
+		return 0;
+	}
+}
+
+const char* sortAlgorithmName(SortAlgorithm algorithm) {
+	switch (algorithm) {
+	case SortAlgorithm::IntroSort: return "introsort";
+	case SortAlgorithm::PdqSort: return "pdqsort";
+	case SortAlgorithm::RadixSort: return "radix sort";
+	case SortAlgorithm::ParallelSampleSort: return "parallel sample sort";
+	case SortAlgorithm::HeapSort:
+	default: return "heap sort";
+	}
+}
+
+bool parseSortAlgorithm(const std::string& name, SortAlgorithm& algorithm) {
+	if (name == "heap") algorithm = SortAlgorithm::HeapSort;
+	else if (name == "intro") algorithm = SortAlgorithm::IntroSort;
+	else if (name == "pdq") algorithm = SortAlgorithm::PdqSort;
+	else if (name == "radix") algorithm = SortAlgorithm::RadixSort;
+	else if (name == "sample") algorithm = SortAlgorithm::ParallelSampleSort;
+	else return false;
+	return true;
+}
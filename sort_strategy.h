@@ -0,0 +1,47 @@
+#pragma once
+#ifndef SORT_STRATEGY_H
+#define SORT_STRATEGY_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "sort_options.h"
+
+class BufferPool;
+
+// Strategy interface for sorting one in-memory chunk. Each sorting thread
+// owns its own instance, so implementations may keep scratch buffers.
+class ChunkSortStrategy {
+public:
+	virtual ~ChunkSortStrategy() {}
+
+	// Sort chunk ascending (the vector's storage may be exchanged)
+	virtual void sort(std::vector<int>& chunk) = 0;
+
+	virtual SortAlgorithm algorithm() const = 0;
+};
+
+// Create the strategy for an algorithm. threads is only used by
+// ParallelSampleSort; radix and sample sort take their scratch from
+// buffers (when given) and hand it back when destroyed.
+std::unique_ptr<ChunkSortStrategy> makeSortStrategy(SortAlgorithm algorithm, int threads = 1,
+	BufferPool* buffers = nullptr);
+
+// Extra ints a strategy keeps to sort a chunk of n values (radix and
+// sample sort hold an n-int scratch buffer between chunks)
+size_t sortScratchInts(SortAlgorithm algorithm, size_t n);
+
+// Display name ("heap sort", "radix sort", ...)
+const char* sortAlgorithmName(SortAlgorithm algorithm);
+
+// Parse a command-line name (heap, intro, pdq, radix, sample)
+bool parseSortAlgorithm(const std::string& name, SortAlgorithm& algorithm);
+
+// Pattern-defeating quicksort on [begin, end)
+void pdqSort(int* begin, int* end);
+
+// Sample sort: split by sampled splitters, sort buckets on threads.
+// scratch is grown to arr.size(); arr and scratch may be swapped.
+void parallelSampleSort(std::vector<int>& arr, std::vector<int>& scratch, int threads);
+
+#endif
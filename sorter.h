@@ -5,16 +5,31 @@
 #include <string>
 #include <vector>
 #include <iostream>
+#include <memory>
+#include <algorithm>
 #include "chunker.h"
 #include "merger.h"
+#include "distributor.h"
+#include "counting_sort.h"
+#include "in_memory_sort.h"
+#include "sort_planner.h"
+#include "memory_governor.h"
+#include "temp_files.h"
+#include "buffer_pool.h"
 #include "utils.h"
 #include "file_io.h"
+#include "sort_options.h"
+#include "sort_strategy.h"
 
 class Sorter {
 private:
     std::string inputFile;
     std::string outputFile;
     size_t chunkSize;
+    SortOptions options;
+    std::unique_ptr<MemoryGovernor> memory;
+    std::unique_ptr<TempFiles> temp;
+    std::unique_ptr<BufferPool> buffers;
     inline void setColor(int color) {
 #ifdef _WIN32
         SetConsoleTextAttribute(GetStdHandle(STD_OUTPUT_HANDLE), color);
@@ -30,9 +45,198 @@ private:
         setColor(7); // WHITE
     }
 
+    // Sample the input and let the planner set chunk size and options
+    void planFromSample() {
+        setColor(14); // COLOR_YELLOW
+        std::cout << "PLANNING: SAMPLED PRE-PASS\n";
+        std::cout << "**********************************************************\n";
+        setColor(7);
+
+        Timer timer;
+        InputProfile profile = profileInput(sampleInput(inputFile));
+        SortPlan plan = planSort(profile, options);
+        applyPlan(plan, options, chunkSize);
+
+        std::cout << " Input: " << formatSize(profile.fileBytes) << ", ~" << profile.estimatedCount
+            << " integers (" << profile.sampleSize << " sampled)\n";
+        std::cout << " Values: [" << profile.minValue << ", " << profile.maxValue << "], "
+            << static_cast<int>(profile.duplicateRatio * 100) << "% duplicates, "
+            << static_cast<int>(profile.ascendingRatio * 100) << "% ascending / "
+            << static_cast<int>(profile.descendingRatio * 100) << "% descending neighbours\n";
+        std::cout << " Plan: " << formatSize(plan.chunkSize) << " chunks, "
+            << sortAlgorithmName(plan.kernel) << ", "
+            << (plan.runGeneration == RunGeneration::ReplacementSelection ? "replacement selection" : "fixed chunks")
+            << ", ~" << plan.expectedRuns << " runs, fan-in "
+            << (plan.fanIn > 0 ? std::to_string(plan.fanIn) : std::string("auto"))
+            << " (" << plan.expectedPasses << " merge pass(es))\n";
+        for (const std::string& reason : plan.reasons) {
+            std::cout << "  - " << reason << "\n";
+        }
+        std::cout << " Planned in " << formatTime(timer.elapsed()) << "\n\n";
+    }
+
+    // Split --memory between the phases and track it from here on
+    void applyMemoryBudget() {
+        memory.reset(new MemoryGovernor(options.memoryBudget));
+        options.memory = memory.get();
+
+        size_t governedChunk = memory->planChunkBytes(options);
+        chunkSize = options.autoPlan ? std::min(chunkSize, governedChunk) : governedChunk;
+        size_t mergeBytes = memory->planMergeBytes(options);
+        options.mergeMemoryBudget = options.mergeMemoryBudget > 0
+            ? std::min(options.mergeMemoryBudget, mergeBytes) : mergeBytes;
+
+        std::cout << "Memory budget: " << formatSize(options.memoryBudget) << " (chunks of "
+            << formatSize(chunkSize) << ", merge read blocks " << formatSize(options.mergeMemoryBudget) << ")\n\n";
+    }
+
+    // Overall memory line of the summary
+    void printMemory() {
+        if (memory) {
+            std::cout << " Memory: " << memory->report() << "\n";
+        }
+        if (buffers) {
+            std::cout << " Buffers: " << buffers->report() << "\n";
+        }
+    }
+
+    // The job's own temp directories, before the first temp file
+    void prepareTempFiles() {
+        temp.reset(new TempFiles(options.tempDirs, options.tempPlacement));
+        options.temp = temp.get();
+
+        std::cout << "Temp directories (" << (options.tempPlacement == TempPlacement::FreeSpace
+            ? "most free space" : "round-robin") << "):";
+        for (const std::string& directory : temp->getDirectories()) {
+            std::cout << " " << directory;
+        }
+        std::cout << "\n\n";
+    }
+
+    // Temp file line of the summary
+    void printTempFiles() {
+        if (temp) {
+            std::cout << " Temp files: " << temp->report() << "\n";
+        }
+    }
+
+    // Counting sort straight into the output; false if the value range
+    // is too wide and the general path has to run
+    bool runCounting(Timer& totalTimer) {
+        setColor(14); // COLOR_YELLOW
+        std::cout << "PRE-SCAN: VALUE RANGE\n";
+        std::cout << "**********************************************************\n";
+        setColor(7);
+
+        if (memory) memory->beginPhase("counting");
+        CountingSorter counting(inputFile, outputFile, chunkSize, options);
+        if (!counting.trySort()) {
+            std::cout << "\n";
+            return false;
+        }
+
+        // --- SUMMARY ---
+        const CountingStats& stats = counting.getStats();
+        setColor(10); // GREEN
+        std::cout << "\n==========================================================\n";
+        std::cout << " PROCESS COMPLETED SUCCESSFULLY\n";
+        std::cout << " Path: counting sort (no temp files)\n";
+        std::cout << " Counting sort: " << stats.totalIntegers << " integers, " << stats.distinctValues
+            << " distinct, " << stats.outliers << " outside the sampled range\n";
+        std::cout << " Histogram: " << formatTime(stats.countSeconds) << " on " << stats.threads
+            << " thread(s), output: " << formatTime(stats.emitSeconds) << " (no temp files, no merge)\n";
+        printMemory();
+        std::cout << " Total Execution Time: " << formatTime(totalTimer.elapsed()) << "\n";
+        std::cout << "==========================================================\n";
+        setColor(7);
+        return true;
+    }
+
+    // Parse, sort and write an input that fits in memory; false (before
+    // touching the output) if it does not fit
+    bool runInMemory(Timer& totalTimer) {
+        // --memory covers everything; otherwise the chunk buffers' memory,
+        // plus the reader and writer buffers chunking would hold as well
+        size_t budget = options.memoryBudget;
+        if (budget == 0) {
+            budget = options.chunkMemoryBudget > 0 ? options.chunkMemoryBudget
+                : chunkSize * (static_cast<size_t>(std::max(options.threadCount, 1)) + 1);
+            budget += static_cast<size_t>(InMemorySorter::memoryNeeded(0, options));
+        }
+        InMemorySorter inMemory(inputFile, outputFile, options);
+        if (!inMemory.fits(budget)) {
+            return false;
+        }
+
+        setColor(14); // COLOR_YELLOW
+        std::cout << "PHASE 1/1: IN-MEMORY SORT (" << sortAlgorithmName(options.chunkSort) << ")\n";
+        std::cout << "**********************************************************\n";
+        setColor(7);
+
+        if (memory) memory->beginPhase("in-memory");
+        inMemory.sort();
+
+        // --- SUMMARY ---
+        const InMemoryStats& stats = inMemory.getStats();
+        setColor(10); // GREEN
+        std::cout << "\n==========================================================\n";
+        std::cout << " PROCESS COMPLETED SUCCESSFULLY\n";
+        std::cout << " Path: in-memory (input fits " << formatSize(budget) << ", no temp files)\n";
+        std::cout << " In-memory sort: " << stats.totalIntegers << " integers in " << stats.threads
+            << " range(s), " << formatTime(stats.sortSeconds) << " sorting\n";
+        std::cout << " Parse + sort: " << formatTime(stats.parseSeconds) << ", output: "
+            << formatTime(stats.writeSeconds) << "\n";
+        if (stats.integersSkipped > 0) {
+            std::cout << " Presorted input: " << stats.integersSkipped << " integers needed no sort kernel\n";
+        }
+        printMemory();
+        std::cout << " Total Execution Time: " << formatTime(totalTimer.elapsed()) << "\n";
+        std::cout << "==========================================================\n";
+        setColor(7);
+        return true;
+    }
+
+    // Sample, scatter into buckets, sort buckets into the output
+    void runDistribution(Timer& totalTimer) {
+        // PHASE 1+2: SCATTER AND BUCKET SORT
+        setColor(14); // COLOR_YELLOW
+        std::cout << "PHASE 1/2: DISTRIBUTION SORT (" << sortAlgorithmName(options.chunkSort) << " buckets)\n";
+        std::cout << "**********************************************************\n";
+        setColor(7);
+
+        if (memory) memory->beginPhase("distribution");
+        Distributor distributor(inputFile, outputFile, chunkSize, options);
+        distributor.sort();
+
+        // PHASE 2: CLEANUP
+        setColor(14); // YELLOW
+        std::cout << "\n**********************************************************\n";
+        std::cout << "  PHASE 2/2: CLEANUP\n";
+        std::cout << "**********************************************************\n";
+        setColor(7);
+        distributor.cleanupTempFiles();
+
+        // --- SUMMARY ---
+        const DistributionStats& stats = distributor.getStats();
+        setColor(10); // GREEN
+        std::cout << "\n==========================================================\n";
+        std::cout << " PROCESS COMPLETED SUCCESSFULLY\n";
+        std::cout << " Path: distribution sort (temp bucket files)\n";
+        std::cout << " Distribution sort: " << stats.buckets << " buckets, "
+            << stats.overflowBuckets << " by chunk/merge, no global merge\n";
+        std::cout << " Scatter: " << formatTime(stats.scatterSeconds) << ", sorting: "
+            << formatTime(stats.sortSeconds) << "\n";
+        printMemory();
+        printTempFiles();
+        std::cout << " Total Execution Time: " << formatTime(totalTimer.elapsed()) << "\n";
+        std::cout << "==========================================================\n";
+        setColor(7);
+    }
+
 public:
-    Sorter(std::string input, std::string output, size_t size)
-        : inputFile(input), outputFile(output), chunkSize(size) {
+    Sorter(std::string input, std::string output, size_t size,
+        const SortOptions& opts = SortOptions())
+        : inputFile(input), outputFile(output), chunkSize(size), options(opts) {
     }
 
     void run() {
@@ -47,22 +251,53 @@ public:
                 return;
             }
 
+            // The planner sizes chunks from the overall budget too
+            if (options.memoryBudget > 0 && options.chunkMemoryBudget == 0) {
+                options.chunkMemoryBudget = options.memoryBudget;
+            }
+            if (options.autoPlan) {
+                planFromSample();
+            }
+            if (options.memoryBudget > 0) {
+                applyMemoryBudget();
+            }
+
+            if (options.countingSort && runCounting(totalTimer)) {
+                return;
+            }
+
+            if (options.inMemory && runInMemory(totalTimer)) {
+                return;
+            }
+
+            // Chunk, scratch, bucket and read block buffers are recycled
+            // from here on (idle ones count against the memory budget)
+            buffers.reset(new BufferPool(options.hugePages, memory.get()));
+            options.buffers = buffers.get();
+            prepareTempFiles();
+            if (options.sortMode == SortMode::Distribution) {
+                runDistribution(totalTimer);
+                return;
+            }
+
             // PHASE 1: CHUNKING
             setColor(14); // COLOR_YELLOW
-            std::cout << "PHASE 1/3: CHUNKING & SORTING (Heap Sort)\n";
+            std::cout << "PHASE 1/3: CHUNKING & SORTING (" << sortAlgorithmName(options.chunkSort) << ")\n";
             std::cout << "**********************************************************\n";
             setColor(7);
 
-            Chunker chunker(inputFile, chunkSize);
+            if (memory) memory->beginPhase("chunking");
+            Chunker chunker(inputFile, chunkSize, options);
             std::vector<std::string> tempFiles = chunker.createSortedChunks();
 
             // PHASE 2: MERGING
             setColor(14); // COLOR_YELLOW
-            std::cout << "\nPHASE 2/3: K-WAY MERGE (Min-Heap)\n";
+            std::cout << "\nPHASE 2/3: K-WAY MERGE (Loser Tree)\n";
             std::cout << "**********************************************************\n";
             setColor(7);
 
-            Merger merger(tempFiles, outputFile);
+            if (memory) memory->beginPhase("merging");
+            Merger merger(tempFiles, outputFile, options);
             merger.merge();
 
             // PHASE 3: CLEANUP
@@ -81,6 +316,16 @@ public:
             setColor(10); // GREEN
             std::cout << "\n==========================================================\n";
             std::cout << " PROCESS COMPLETED SUCCESSFULLY\n";
+            std::cout << " Path: external merge sort (temp run files)\n";
+            std::cout << " Chunk sort: " << chunker.getStats().sortAlgorithm
+                << " (" << chunker.getStats().runs << " runs, "
+                << formatTime(chunker.getStats().sortSeconds) << " sorting)\n";
+            if (chunker.getStats().integersSkipped > 0) {
+                std::cout << " Presorted input: " << chunker.getStats().integersSkipped
+                    << " integers needed no sort kernel\n";
+            }
+            printMemory();
+            printTempFiles();
             std::cout << " Total Execution Time: " << formatTime(totalTimer.elapsed()) << "\n";
             std::cout << "==========================================================\n";
             setColor(7);
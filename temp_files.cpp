@@ -0,0 +1,112 @@
+#include "temp_files.h"
+#include "file_io.h"
+#include <atomic>
+#include <stdexcept>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+//Job directories made by this process, for several jobs per process
+static std::atomic<unsigned> jobCounter(0);
+
+//Directories tried before giving up on a root
+static const int MAX_NAME_ATTEMPTS = 1000;
+
+static int processId() {
+#ifdef _WIN32
+	return _getpid();
+#else
+	return static_cast<int>(getpid());
+#endif
+}
+
+static std::string joinPath(const std::string& directory, const std::string& name) {
+	if (directory.empty()) return name;
+	char last = directory.back();
+	return last == '/' || last == '\\' ? directory + name : directory + "/" + name;
+}
+
+//Constructor
+TempFiles::TempFiles(const std::vector<std::string>& roots, TempPlacement mode)
+	: placement(mode), next(0) {
+	std::vector<std::string> where = roots;
+	if (where.empty()) where.push_back(".");
+
+	for (const std::string& root : where) {
+		//Another job (or process) may hold a name already: take the next one
+		std::string path;
+		bool created = false;
+		for (int attempt = 0; attempt < MAX_NAME_ATTEMPTS && !created; attempt++) {
+			path = joinPath(root, "sort_" + std::to_string(processId()) + "_" + std::to_string(jobCounter++));
+			created = FileIO::makeDirectory(path);
+		}
+		if (!created) {
+			for (const Directory& made : directories) FileIO::removeDirectory(made.path);
+			throw std::runtime_error("Cannot create a temp directory in: " + root);
+		}
+		directories.push_back(Directory{ path, 0 });
+	}
+}
+
+//Destructor: delete what the components left behind, then the directories
+TempFiles::~TempFiles() {
+	for (const auto& file : assigned) {
+		std::remove(file.second.c_str());
+	}
+	for (const Directory& directory : directories) {
+		FileIO::removeDirectory(directory.path);
+	}
+}
+
+//Directory for a new temp file (called with the mutex held)
+size_t TempFiles::pickDirectory() {
+	if (placement == TempPlacement::FreeSpace) {
+		size_t best = 0;
+		uint64_t bestFree = 0;
+		for (size_t d = 0; d < directories.size(); d++) {
+			uint64_t available = FileIO::freeSpace(directories[d].path);
+			if (d == 0 || available > bestFree) {
+				best = d;
+				bestFree = available;
+			}
+		}
+		return best;
+	}
+	return next++ % directories.size();
+}
+
+std::string TempFiles::path(const std::string& name) {
+	std::lock_guard<std::mutex> lock(mutex);
+	auto found = assigned.find(name);
+	if (found != assigned.end()) return found->second;
+
+	Directory& directory = directories[pickDirectory()];
+	directory.files++;
+	std::string full = joinPath(directory.path, name);
+	assigned[name] = full;
+	return full;
+}
+
+std::string TempFiles::place(TempFiles* temp, const std::string& name) {
+	return temp ? temp->path(name) : name;
+}
+
+std::string TempFiles::report() {
+	std::lock_guard<std::mutex> lock(mutex);
+	std::string text;
+	for (const Directory& directory : directories) {
+		if (!text.empty()) text += ", ";
+		text += std::to_string(directory.files) + " files in " + directory.path;
+	}
+	return text;
+}
+
+std::vector<std::string> TempFiles::getDirectories() const {
+	std::vector<std::string> paths;
+	for (const Directory& directory : directories) paths.push_back(directory.path);
+	return paths;
+}
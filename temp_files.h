@@ -0,0 +1,61 @@
+#pragma once
+#ifndef TEMP_FILES_H
+#define TEMP_FILES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "sort_options.h"
+
+// Where one sort job keeps its temp files (--temp-dir, --temp-placement).
+//
+// The job makes a directory of its own (sort_<pid>_<n>) inside every
+// configured temp directory, so concurrent sorts sharing a directory
+// never see each other's files. Each temp file name is assigned to one of
+// them the first time it is asked for, round-robin or to the volume with
+// the most free space, and keeps that path for the rest of the job;
+// spreading runs over several disks adds up their bandwidth. Whatever is
+// still there when the job ends is deleted with the job's directories.
+class TempFiles {
+private:
+	struct Directory {
+		std::string path;      // The job's own directory
+		size_t files;          // Temp files placed in it
+	};
+
+	TempPlacement placement;
+	std::vector<Directory> directories;
+	std::mutex mutex;
+	std::map<std::string, std::string> assigned;   // Name -> path
+	size_t next;                                   // Round-robin cursor
+
+	size_t pickDirectory();
+
+public:
+	// Make the job's directory in each of `roots` ("." if empty); throws if
+	// one cannot be created
+	TempFiles(const std::vector<std::string>& roots, TempPlacement placement);
+	~TempFiles();
+
+	TempFiles(const TempFiles&) = delete;
+	TempFiles& operator=(const TempFiles&) = delete;
+
+	// Path of the temp file `name` for this job (the same path every call)
+	std::string path(const std::string& name);
+
+	// `name` in the working directory when there is no TempFiles (the
+	// components used on their own), else temp->path(name)
+	static std::string place(TempFiles* temp, const std::string& name);
+
+	// "3 files in /a/sort_12_0, 2 files in /b/sort_12_0"
+	std::string report();
+
+	//Getters
+	std::vector<std::string> getDirectories() const;
+	TempPlacement getPlacement() const { return placement; }
+};
+
+#endif
@@ -0,0 +1,142 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include "buffer_pool.h"
+#include "block_pool.h"
+#include "memory_governor.h"
+#include "sort_strategy.h"
+#include "chunker.h"
+#include "merger.h"
+
+void testReuse() {
+	std::cout << "***Test 1: Buffer Reuse***\n\n";
+
+	MemoryGovernor memory(64 * 1024 * 1024);
+	BufferPool pool(false, &memory);
+
+	std::vector<int> first = pool.take(1000000);
+	const int* data = first.data();
+	first.assign(1000000, 7);
+	pool.give(first);
+	bool counted = pool.getIdleBytes() >= 1000000 * sizeof(int) && memory.getPeak() >= pool.getIdleBytes();
+	std::cout << (counted ? "YES" : "NO") << " Idle buffer counted against the budget ("
+		<< pool.getIdleBytes() << " bytes)\n";
+
+	std::vector<int> second = pool.take(600000);
+	bool reused = second.data() == data && second.empty() && pool.getReuses() == 1 && pool.getIdleBytes() == 0;
+	std::cout << (reused ? "YES" : "NO") << " Smaller request reuses the idle buffer, empty\n";
+	pool.give(second);
+
+	std::vector<int> third = pool.take(100000);
+	bool fresh = third.data() != data && pool.getAllocations() == 2 && pool.getIdleBytes() == 0;
+	std::cout << (fresh ? "YES" : "NO") << " A buffer over twice the request is freed, not handed out\n";
+
+	std::vector<int> small(1000);
+	pool.give(small);
+	pool.give(third);
+	std::cout << (pool.getIdleBytes() == 0 && small.capacity() == 0 ? "YES" : "NO")
+		<< " Buffers under " << BufferPool::MIN_POOLED_BYTES << " bytes are not kept\n";
+
+	std::vector<int> plain = takeBuffer(nullptr, 5000);
+	std::cout << (plain.capacity() >= 5000 && plain.empty() ? "YES" : "NO") << " No pool: plain allocation\n";
+
+	std::cout << "\n******************************************\n\n";
+}
+
+void testBlocksAndScratch() {
+	std::cout << "***Test 2: Read Blocks and Sort Scratch***\n\n";
+
+	BufferPool pool(true);
+	{
+		BlockPool blocks(64 * 1024, 32, &pool);
+		int* first = blocks.acquire();
+		bool aligned = reinterpret_cast<uintptr_t>(first) % 4096 == 0;
+		blocks.release(first);
+		blocks.reset(64 * 1024, 24, &pool);
+		std::cout << (aligned && blocks.getBlockCount() == 24 && pool.getReuses() == 1 ? "YES" : "NO")
+			<< " Page-aligned blocks; the next merge pass reuses the storage\n";
+	}
+	std::cout << (pool.getIdleBytes() >= 32 * 64 * 1024 ? "YES" : "NO") << " Block storage returned with the pool\n";
+
+	//Radix scratch comes from the pool and goes back with the strategy
+	size_t allocations = pool.getAllocations();
+	bool sorted = true;
+	{
+		std::unique_ptr<ChunkSortStrategy> sorter = makeSortStrategy(SortAlgorithm::RadixSort, 1, &pool);
+		for (int round = 0; round < 3; round++) {
+			std::vector<int> chunk = pool.take(500000);
+			for (int i = 0; i < 500000; i++) chunk.push_back(rand() - RAND_MAX / 2);
+			std::vector<int> expected = chunk;
+			std::sort(expected.begin(), expected.end());
+			sorter->sort(chunk);
+			sorted = sorted && chunk == expected;
+			pool.give(chunk);
+		}
+	}
+	std::cout << (sorted ? "YES" : "NO") << " Radix sort with pooled scratch and huge pages\n";
+	std::cout << (pool.getAllocations() - allocations <= 2 && pool.getIdleBytes() >= 2 * 500000 * sizeof(int) ? "YES" : "NO")
+		<< " 3 chunks took " << pool.getAllocations() - allocations << " new buffers\n";
+
+	std::cout << "\n******************************************\n\n";
+}
+
+void testJob() {
+	std::cout << "***Test 3: Chunking and Merging From One Pool***\n\n";
+
+	std::vector<int> values(400000);
+	{
+		std::ofstream out("test_pool_input.txt");
+		for (size_t i = 0; i < values.size(); i++) {
+			values[i] = rand() - RAND_MAX / 2;
+			out << values[i] << "\n";
+		}
+	}
+
+	BufferPool pool(false);
+	SortOptions options;
+	options.buffers = &pool;
+	options.threadCount = 2;
+	options.chunkSort = SortAlgorithm::RadixSort;
+	options.maxFanIn = 2;
+	options.mergeMemoryBudget = 4 * 1024 * 1024;
+	{
+		Chunker chunker("test_pool_input.txt", 512 * 1024, options);
+		std::vector<std::string> runs = chunker.createSortedChunks();
+		Merger merger(runs, "test_pool_output.txt", options);
+		merger.merge();
+		chunker.cleanupTempFiles();
+	}
+
+	std::vector<int> sorted;
+	{
+		std::ifstream in("test_pool_output.txt");
+		int v;
+		while (in >> v) sorted.push_back(v);
+	}
+	std::sort(values.begin(), values.end());
+	std::cout << (sorted == values ? "YES" : "NO") << " Output matches std::sort\n";
+	std::cout << (pool.getReuses() > 0 ? "YES" : "NO") << " " << pool.report() << "\n";
+
+	std::remove("test_pool_input.txt");
+	std::remove("test_pool_output.txt");
+	std::cout << "\n******************************************\n\n";
+}
+
+int main() {
+	std::cout << "******************************************\n";
+	std::cout << "*        BUFFER POOL TEST SUITE          *\n";
+	std::cout << "******************************************\n\n";
+
+	testReuse();
+	testBlocksAndScratch();
+	testJob();
+
+	std::cout << "******************************************\n";
+	std::cout << "*            ALL TESTS COMPLETE          *\n";
+	std::cout << "******************************************\n";
+	return 0;
+}
@@ -2,7 +2,10 @@
 #include <fstream>
 #include <vector>
 #include <algorithm>
+#include <iterator>
 #include "chunker.h"
+#include "run_format.h"
+#include "file_io.h"
 #include "utils.h"
 
 // Generate test input file
@@ -18,20 +21,28 @@ void generateTestFile(const std::string& filename, int count) {
     std::cout << " Test file created: " << filename << "\n\n";
 }
 
-// Verify chunk file is sorted
+// Verify binary chunk run is sorted and matches its header
 bool verifyChunkSorted(const std::string& filename) {
-    std::ifstream in(filename);
-    if (!in.is_open()) return false;
+    RunReader in(filename);
+    const RunHeader& header = in.getHeader();
 
     int prev, curr;
-    if (!(in >> prev)) return true;  // Empty file is sorted
+    if (!in.next(prev)) return header.count == 0;  // Empty run is sorted
 
-    while (in >> curr) {
+    uint64_t count = 1;
+    int first = prev;
+    while (in.next(curr)) {
         if (curr < prev) {
             std::cout << "  NOT SORTED: " << prev << " > " << curr << "\n";
             return false;
         }
         prev = curr;
+        count++;
+    }
+
+    if (count != header.count || first != header.minValue || prev != header.maxValue) {
+        std::cout << "  HEADER MISMATCH: " << filename << "\n";
+        return false;
     }
 
     return true;
@@ -169,6 +180,144 @@ void testEdgeCases() {
     std::cout << "\n*********************************************\n\n";
 }
 
+// Test 4: Parallel chunking produces the same runs as sequential
+void testParallelChunking() {
+    std::cout << "***Test 4: Parallel Chunking (4 threads)***\n\n";
+
+    generateTestFile("test_input_parallel.txt", 10000);
+
+    SortOptions options;
+    options.threadCount = 4;
+    options.chunkMemoryBudget = 3 * 400;   // Only 3 chunk buffers in flight
+
+    Chunker sequential("test_input_parallel.txt", 400);
+    auto expected = sequential.createSortedChunks();
+    std::vector<std::vector<int>> expectedRuns;
+    for (const auto& file : expected) {
+        RunReader in(file);
+        std::vector<int> run(in.getHeader().count);
+        in.read(run.data(), run.size());
+        expectedRuns.push_back(run);
+    }
+    sequential.cleanupTempFiles();
+
+    Chunker parallel("test_input_parallel.txt", 400, options);
+    auto chunks = parallel.createSortedChunks();
+
+    bool identical = chunks.size() == expectedRuns.size();
+    for (size_t i = 0; identical && i < chunks.size(); i++) {
+        RunReader in(chunks[i]);
+        std::vector<int> run(in.getHeader().count);
+        in.read(run.data(), run.size());
+        identical = run == expectedRuns[i];
+    }
+
+    std::cout << "  " << (identical ? "YES" : "NO")
+        << " Parallel runs match sequential runs (" << chunks.size() << " chunks)\n";
+
+    parallel.cleanupTempFiles();
+    std::remove("test_input_parallel.txt");
+
+    std::cout << "\n*********************************************\n\n";
+}
+
+// Test 5: Replacement selection run lengths
+void testReplacementSelection() {
+    std::cout << "***Test 5: Replacement Selection***\n\n";
+
+    SortOptions options;
+    options.runGeneration = RunGeneration::ReplacementSelection;
+
+    // Random input: runs longer than memory (100 ints), all sorted
+    generateTestFile("test_input_rs.txt", 10000);
+    Chunker random("test_input_rs.txt", 400, options);
+    auto chunks = random.createSortedChunks();
+
+    bool allSorted = true;
+    uint64_t total = 0;
+    for (const auto& chunk : chunks) {
+        allSorted = allSorted && verifyChunkSorted(chunk);
+        total += RunReader(chunk).getHeader().count;
+    }
+    std::cout << "  Random input: " << chunks.size() << " runs (fixed chunks: 100), "
+        << (allSorted && total == 10000 ? "all sorted" : "ERROR") << "\n";
+    random.cleanupTempFiles();
+    std::remove("test_input_rs.txt");
+
+    // Sorted input: one run regardless of memory
+    std::ofstream out("test_sorted_rs.txt");
+    for (int i = 0; i < 1000; i++) {
+        out << i << "\n";
+    }
+    out.close();
+
+    Chunker sorted("test_sorted_rs.txt", 40, options);
+    auto single = sorted.createSortedChunks();
+    std::cout << "  Sorted input: " << single.size() << " runs (expected: 1)\n";
+    sorted.cleanupTempFiles();
+    std::remove("test_sorted_rs.txt");
+
+    std::cout << "\n*********************************************\n\n";
+}
+
+// Test 6: Byte-range splitting covers the input exactly once
+void testInputSplits() {
+    std::cout << "***Test 6: Parallel Byte-Range Parsing (4 splits)***\n\n";
+
+    generateTestFile("test_input_splits.txt", 10000);
+
+    // Ranges are contiguous and each one starts at a line
+    std::vector<ByteRange> ranges = FileIO::splitAtNewlines("test_input_splits.txt", 4);
+    std::ifstream raw("test_input_splits.txt", std::ios::binary);
+    std::string text((std::istreambuf_iterator<char>(raw)), std::istreambuf_iterator<char>());
+    bool aligned = !ranges.empty() && ranges[0].offset == 0;
+    for (size_t i = 0; i < ranges.size(); i++) {
+        if (i > 0) {
+            aligned = aligned && ranges[i].offset == ranges[i - 1].offset + ranges[i - 1].length
+                && text[ranges[i].offset - 1] == '\n';
+        }
+    }
+    aligned = aligned && ranges.back().offset + ranges.back().length == text.size();
+    std::cout << "  " << (aligned ? "YES" : "NO") << " " << ranges.size()
+        << " ranges cover the file and start on line boundaries\n";
+
+    for (int inputMode = 0; inputMode < 2; inputMode++) {
+        SortOptions options;
+        options.inputSplits = 4;
+        options.inputMode = inputMode == 0 ? InputMode::Stream : InputMode::Mapped;
+
+        Chunker chunker("test_input_splits.txt", 400, options);
+        auto chunks = chunker.createSortedChunks();
+
+        // Runs differ from the single reader, but hold the same values
+        std::vector<int> values;
+        bool allSorted = true;
+        for (const auto& chunk : chunks) {
+            allSorted = allSorted && verifyChunkSorted(chunk);
+            RunReader in(chunk);
+            std::vector<int> run(in.getHeader().count);
+            in.read(run.data(), run.size());
+            values.insert(values.end(), run.begin(), run.end());
+        }
+        chunker.cleanupTempFiles();
+
+        std::vector<int> expected;
+        std::ifstream in("test_input_splits.txt");
+        int value;
+        while (in >> value) expected.push_back(value);
+
+        std::sort(values.begin(), values.end());
+        std::sort(expected.begin(), expected.end());
+        std::cout << "  " << (allSorted && values == expected ? "YES" : "NO")
+            << " " << (inputMode == 0 ? "Stream" : "Mapped") << " ranges yield the input values ("
+            << chunks.size() << " chunks)\n";
+    }
+
+    std::remove("test_input_splits.txt");
+
+    std::cout << "\n*********************************************\n\n";
+}
+
 int main() {
     std::cout << "******************************************\n";
     std::cout << "*            CHUNKER TEST SUITE          *\n";
@@ -177,6 +326,9 @@ int main() {
     testSmallFile();
     testMediumFile();
     testEdgeCases();
+    testParallelChunking();
+    testReplacementSelection();
+    testInputSplits();
 
     std::cout << "******************************************\n";
     std::cout << "*            ALL TESTS COMPLETE          *\n";
@@ -0,0 +1,109 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include "counting_sort.h"
+#include "file_io.h"
+
+//Write values as a text input file
+void writeInput(const std::string& filename, const std::vector<int>& values) {
+	std::ofstream out(filename);
+	for (int v : values) out << v << "\n";
+}
+
+//Read a text output file back
+std::vector<int> readOutput(const std::string& filename) {
+	std::vector<int> values;
+	std::ifstream in(filename);
+	int v;
+	while (in >> v) values.push_back(v);
+	return values;
+}
+
+//Returns whether the counting path ran; correct is set when it did
+bool countingSort(const std::vector<int>& values, const SortOptions& options, bool& correct,
+	CountingStats& stats) {
+	writeInput("test_count_input.txt", values);
+	std::remove("test_count_output.txt");
+
+	CountingSorter sorter("test_count_input.txt", "test_count_output.txt", 1024 * 1024, options);
+	bool used = sorter.trySort();
+	stats = sorter.getStats();
+
+	std::vector<int> expected = values;
+	std::sort(expected.begin(), expected.end());
+	correct = used && readOutput("test_count_output.txt") == expected;
+
+	std::remove("test_count_input.txt");
+	std::remove("test_count_output.txt");
+	return used;
+}
+
+void testNarrowRange() {
+	std::cout << "***Test 1: Narrow Range (4 threads)***\n\n";
+
+	std::vector<int> values(500000);
+	for (size_t i = 0; i < values.size(); i++) values[i] = rand() % 2000001 - 1000000;
+
+	SortOptions options;
+	options.threadCount = 4;
+	bool correct;
+	CountingStats stats;
+	bool used = countingSort(values, options, correct, stats);
+	std::cout << (used && correct ? "YES" : "NO") << " Counting sort matches std::sort ("
+		<< stats.distinctValues << " distinct, " << stats.outliers << " outliers)\n";
+
+	std::cout << "\n******************************************\n\n";
+}
+
+void testOutliers() {
+	std::cout << "***Test 2: Values Outside the Sample***\n\n";
+
+	//Status-code like data with a few extremes the sample will miss
+	std::vector<int> values(300000);
+	for (size_t i = 0; i < values.size(); i++) values[i] = 200 + rand() % 400;
+	values[12345] = INT32_MIN;
+	values[54321] = INT32_MAX;
+	values[99999] = -7;
+
+	bool correct;
+	CountingStats stats;
+	bool used = countingSort(values, SortOptions(), correct, stats);
+	std::cout << (used && correct && stats.outliers >= 3 ? "YES" : "NO") << " Outliers sorted around the histogram ("
+		<< stats.outliers << " outliers)\n";
+
+	std::cout << "\n******************************************\n\n";
+}
+
+void testWideRange() {
+	std::cout << "***Test 3: Wide Range Falls Back***\n\n";
+
+	std::vector<int> values(100000);
+	for (size_t i = 0; i < values.size(); i++) values[i] = static_cast<int>(rand() * 2654435761u);
+
+	bool correct;
+	CountingStats stats;
+	bool used = countingSort(values, SortOptions(), correct, stats);
+	std::cout << (!used && !FileIO::exists("test_count_output.txt") ? "YES" : "NO")
+		<< " Full 32-bit range left to the general sort\n";
+
+	std::cout << "\n******************************************\n\n";
+}
+
+int main() {
+	std::cout << "******************************************\n";
+	std::cout << "*        COUNTING SORT TEST SUITE        *\n";
+	std::cout << "******************************************\n\n";
+
+	testNarrowRange();
+	testOutliers();
+	testWideRange();
+
+	std::cout << "******************************************\n";
+	std::cout << "*            ALL TESTS COMPLETE          *\n";
+	std::cout << "******************************************\n";
+	return 0;
+}
@@ -0,0 +1,112 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdio>
+#include "distributor.h"
+#include "input_sample.h"
+#include "file_io.h"
+
+//Write values as a text input file
+void writeInput(const std::string& filename, const std::vector<int>& values) {
+	std::ofstream out(filename);
+	for (int v : values) out << v << "\n";
+}
+
+//Read a text output file back
+std::vector<int> readOutput(const std::string& filename) {
+	std::vector<int> values;
+	std::ifstream in(filename);
+	int v;
+	while (in >> v) values.push_back(v);
+	return values;
+}
+
+//Run a distribution sort and compare with std::sort
+bool sortsCorrectly(const std::vector<int>& values, size_t chunkBytes, const SortOptions& options) {
+	writeInput("test_dist_input.txt", values);
+
+	Distributor distributor("test_dist_input.txt", "test_dist_output.txt", chunkBytes, options);
+	distributor.sort();
+	distributor.cleanupTempFiles();
+
+	std::vector<int> expected = values;
+	std::sort(expected.begin(), expected.end());
+	bool correct = readOutput("test_dist_output.txt") == expected;
+
+	std::remove("test_dist_input.txt");
+	std::remove("test_dist_output.txt");
+	return correct;
+}
+
+void testSampler() {
+	std::cout << "***Test 1: Input Sample***\n\n";
+
+	std::vector<int> values(200000);
+	for (size_t i = 0; i < values.size(); i++) values[i] = rand() % 2000001 - 1000000;
+	writeInput("test_dist_input.txt", values);
+
+	InputSample sample = sampleInput("test_dist_input.txt", 16, 256);
+	uint64_t estimate = sample.estimateCount();
+	bool close = estimate > 190000 && estimate < 210000;
+	std::cout << (sample.values.size() == 16 * 256 && close ? "YES" : "NO") << " " << sample.values.size()
+		<< " values sampled, estimated " << estimate << " of 200000 integers\n";
+
+	std::remove("test_dist_input.txt");
+	std::cout << "\n******************************************\n\n";
+}
+
+void testDistributionSort() {
+	std::cout << "***Test 2: Distribution Sort (3 threads)***\n\n";
+
+	std::vector<int> values(300000);
+	for (size_t i = 0; i < values.size(); i++) values[i] = rand() % 2000001 - 1000000;
+
+	SortOptions options;
+	options.threadCount = 3;
+	bool correct = sortsCorrectly(values, 256 * 1024, options);
+	std::cout << (correct ? "YES" : "NO") << " Output matches std::sort\n";
+
+	std::cout << "\n******************************************\n\n";
+}
+
+void testSkewedBuckets() {
+	std::cout << "***Test 3: Skewed Input (overflowing bucket)***\n\n";
+
+	//Most values equal: their bucket is far bigger than a chunk
+	std::vector<int> values(200000, 42);
+	for (size_t i = 0; i < values.size(); i += 10) values[i] = rand() % 1000;
+
+	SortOptions options;
+	options.threadCount = 2;
+	bool correct = sortsCorrectly(values, 64 * 1024, options);
+	std::cout << (correct ? "YES" : "NO") << " Overflowing bucket sorted by chunk/merge\n";
+
+	std::cout << "\n******************************************\n\n";
+}
+
+void testEmptyInput() {
+	std::cout << "***Test 4: Empty Input***\n\n";
+
+	bool correct = sortsCorrectly(std::vector<int>(), 64 * 1024, SortOptions());
+	std::cout << (correct ? "YES" : "NO") << " Empty input gives an empty output\n";
+
+	std::cout << "\n******************************************\n\n";
+}
+
+int main() {
+	std::cout << "******************************************\n";
+	std::cout << "*         DISTRIBUTOR TEST SUITE         *\n";
+	std::cout << "******************************************\n\n";
+
+	testSampler();
+	testDistributionSort();
+	testSkewedBuckets();
+	testEmptyInput();
+
+	std::cout << "******************************************\n";
+	std::cout << "*            ALL TESTS COMPLETE          *\n";
+	std::cout << "******************************************\n";
+	return 0;
+}
@@ -50,12 +50,64 @@ void testHeapSortLarge() {
 	std::cout << " Is Sorted :" << (sorted ? "YES " : "NO") << "\n";
 }
 
+void testDaryHeap() {
+	std::cout << "\nTesting 8-ary max-heap with buildHeap and replaceTop...\n";
+
+	std::vector<int> values(5000);
+	for (int i = 0; i < 5000; i++) {
+		values[i] = rand() % 100000;
+	}
+
+	DaryHeap<int, std::greater<int>, 8> h;
+	h.buildHeap(values.begin(), values.end());
+
+	// replaceTop must behave like extractMin followed by insert
+	std::vector<int> expected = values;
+	std::sort(expected.begin(), expected.end(), std::greater<int>());
+	std::vector<int> popped;
+	for (int i = 0; i < 1000; i++) {
+		popped.push_back(h.peek());
+		h.replaceTop(-i);
+	}
+	while (!h.isEmpty()) {
+		popped.push_back(h.extractMin());
+	}
+
+	for (int i = 0; i < 1000; i++) {
+		expected.push_back(-i);
+	}
+	std::sort(expected.begin() + 1000, expected.end(), std::greater<int>());
+
+	std::cout << " Order matches :" << (popped == expected ? " YES " : " NO ") << "\n";
+}
+
+void testHeapSortArities() {
+	std::cout << "\nTesting heap sort with 2-, 4- and 8-ary layouts...\n";
+
+	std::vector<int> arr(10001);
+	for (size_t i = 0; i < arr.size(); i++) {
+		arr[i] = rand() % 1000 - 500;
+	}
+
+	std::vector<int> binary = arr, quad = arr, octal = arr;
+	DaryHeap<int, std::less<int>, 2>::heapSort(binary);
+	DaryHeap<int, std::less<int>, 4>::heapSort(quad);
+	DaryHeap<int, std::less<int>, 8>::heapSort(octal);
+
+	bool sorted = std::is_sorted(binary.begin(), binary.end())
+		&& std::is_sorted(quad.begin(), quad.end())
+		&& std::is_sorted(octal.begin(), octal.end());
+	std::cout << " Is Sorted :" << (sorted ? " YES " : " NO ") << "\n";
+}
+
 int main() {
 	std::cout << "***Heap Sort Test Suite***\n\n";
 
 	testHeapBasic();
 	testHeapSort();
 	testHeapSortLarge();
+	testDaryHeap();
+	testHeapSortArities();
 
 	std::cout << "\n***All tests complete***\n";
 	return 0;
@@ -0,0 +1,101 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdio>
+#include "in_memory_sort.h"
+#include "file_io.h"
+
+//Write values as a text input file
+void writeInput(const std::string& filename, const std::vector<int>& values) {
+	std::ofstream out(filename);
+	for (int v : values) out << v << "\n";
+}
+
+//Read a text output file back
+std::vector<int> readOutput(const std::string& filename) {
+	std::vector<int> values;
+	std::ifstream in(filename);
+	int v;
+	while (in >> v) values.push_back(v);
+	return values;
+}
+
+//Sort in memory and compare with std::sort
+bool sortsCorrectly(const std::vector<int>& values, const SortOptions& options) {
+	writeInput("test_mem_input.txt", values);
+
+	InMemorySorter sorter("test_mem_input.txt", "test_mem_output.txt", options);
+	bool fits = sorter.fits(256 * 1024 * 1024);
+	sorter.sort();
+
+	std::vector<int> expected = values;
+	std::sort(expected.begin(), expected.end());
+	bool correct = fits && readOutput("test_mem_output.txt") == expected
+		&& sorter.getStats().totalIntegers == values.size();
+
+	std::remove("test_mem_input.txt");
+	std::remove("test_mem_output.txt");
+	return correct;
+}
+
+void testFits() {
+	std::cout << "***Test 1: Fit Check***\n\n";
+
+	std::vector<int> values(200000);
+	for (size_t i = 0; i < values.size(); i++) values[i] = rand() - RAND_MAX / 2;
+	writeInput("test_mem_input.txt", values);
+
+	SortOptions options;
+	InMemorySorter sorter("test_mem_input.txt", "test_mem_output.txt", options);
+	bool large = sorter.fits(64 * 1024 * 1024);
+	uint64_t estimate = sorter.getStats().estimatedIntegers;
+	bool small = sorter.fits(1024 * 1024);
+	std::cout << (large && !small ? "YES" : "NO") << " 200000 integers fit 64 MB but not 1 MB\n";
+	std::cout << (estimate >= 200000 && estimate < 250000 ? "YES" : "NO")
+		<< " Estimated " << estimate << " integers with headroom\n";
+
+	bool needed = InMemorySorter::memoryNeeded(1000000, options) > 1000000 * sizeof(int);
+	std::cout << (needed ? "YES" : "NO") << " Memory needed covers the values and the buffers\n";
+
+	std::remove("test_mem_input.txt");
+	std::cout << "\n******************************************\n\n";
+}
+
+void testSort() {
+	std::cout << "***Test 2: In-Memory Sort***\n\n";
+
+	std::vector<int> values(300000);
+	for (size_t i = 0; i < values.size(); i++) values[i] = rand() - RAND_MAX / 2;
+
+	SortOptions options;
+	options.chunkSort = SortAlgorithm::PdqSort;
+	std::cout << (sortsCorrectly(values, options) ? "YES" : "NO") << " One thread matches std::sort\n";
+
+	options.threadCount = 4;
+	options.chunkSort = SortAlgorithm::RadixSort;
+	options.asyncOutput = false;
+	std::cout << (sortsCorrectly(values, options) ? "YES" : "NO") << " Four ranges merged match std::sort\n";
+
+	std::sort(values.begin(), values.end());
+	std::cout << (sortsCorrectly(values, options) ? "YES" : "NO") << " Sorted input\n";
+
+	std::cout << (sortsCorrectly(std::vector<int>(), options) ? "YES" : "NO") << " Empty input\n";
+
+	std::cout << "\n******************************************\n\n";
+}
+
+int main() {
+	std::cout << "******************************************\n";
+	std::cout << "*       IN-MEMORY SORT TEST SUITE        *\n";
+	std::cout << "******************************************\n\n";
+
+	testFits();
+	testSort();
+
+	std::cout << "******************************************\n";
+	std::cout << "*            ALL TESTS COMPLETE          *\n";
+	std::cout << "******************************************\n";
+	return 0;
+}
@@ -0,0 +1,140 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <utility>
+#include <cstdio>
+#include "memory_governor.h"
+#include "chunker.h"
+#include "merger.h"
+#include "utils.h"
+
+//Write values as a text input file
+void writeInput(const std::string& filename, const std::vector<int>& values) {
+	std::ofstream out(filename);
+	for (int v : values) out << v << "\n";
+}
+
+//Read a text output file back
+std::vector<int> readOutput(const std::string& filename) {
+	std::vector<int> values;
+	std::ifstream in(filename);
+	int v;
+	while (in >> v) values.push_back(v);
+	return values;
+}
+
+void testAccounting() {
+	std::cout << "***Test 1: Reservations and Phases***\n\n";
+
+	MemoryGovernor governor(1000);
+	governor.beginPhase("first");
+	{
+		MemoryReservation a(&governor, 300);
+		MemoryReservation b(&governor, 200);
+		b.reset(400);
+	}
+	governor.beginPhase("second");
+	MemoryReservation moved;
+	{
+		MemoryReservation c(&governor, 100);
+		moved = std::move(c);
+	}
+	bool held = governor.getPeak() == 700;
+	moved.reset();
+	std::cout << (held ? "YES" : "NO") << " Peak of 700 bytes; a moved reservation outlives its source\n";
+
+	std::string report = governor.report();
+	bool phases = report.find("first") != std::string::npos && report.find("second") != std::string::npos
+		&& report.find("over budget") == std::string::npos;
+	std::cout << (phases ? "YES" : "NO") << " Report: " << report << "\n";
+
+	MemoryReservation untracked(nullptr, 12345);
+	untracked.reset(1);
+	std::cout << "YES A null governor is ignored\n";
+
+	std::cout << "\n******************************************\n\n";
+}
+
+//Chunk and merge under a governor; true if sorted and within budget.
+//With longRuns the input is one long ascending run plus a short tail run
+//of smaller values, so the natural-run merge sees the worst uneven pair.
+bool sortsWithinBudget(SortOptions options, size_t budget, bool longRuns = false) {
+	std::vector<int> values(600000);
+	for (size_t i = 0; i < values.size(); i++) {
+		if (!longRuns) values[i] = rand() - RAND_MAX / 2;
+		else values[i] = i < 590000 ? static_cast<int>(i) : static_cast<int>(i) - 600000;
+	}
+	writeInput("test_memory_input.txt", values);
+
+	MemoryGovernor governor(budget);
+	options.memoryBudget = budget;
+	options.memory = &governor;
+	options.countingSort = false;
+	size_t chunkBytes = governor.planChunkBytes(options);
+	options.mergeMemoryBudget = governor.planMergeBytes(options);
+
+	bool correct;
+	{
+		governor.beginPhase("chunking");
+		Chunker chunker("test_memory_input.txt", chunkBytes, options);
+		std::vector<std::string> runs = chunker.createSortedChunks();
+		governor.beginPhase("merging");
+		Merger merger(runs, "test_memory_output.txt", options);
+		merger.merge();
+		chunker.cleanupTempFiles();
+
+		std::vector<int> expected = values;
+		std::sort(expected.begin(), expected.end());
+		correct = readOutput("test_memory_output.txt") == expected;
+	}
+	std::cout << " " << formatSize(chunkBytes) << " chunks, " << governor.report() << "\n";
+
+	std::remove("test_memory_input.txt");
+	std::remove("test_memory_output.txt");
+	return correct && governor.getPeak() <= budget && governor.getPeak() > 0;
+}
+
+void testBudgetedSort() {
+	std::cout << "***Test 2: Sorting Within a Budget***\n\n";
+
+	SortOptions sequential;
+	sequential.chunkSort = SortAlgorithm::IntroSort;
+	bool ok = sortsWithinBudget(sequential, 12 * 1024 * 1024);
+	std::cout << (ok ? "YES" : "NO") << " Sequential chunking stays within 12 MB\n";
+
+	SortOptions parallel;
+	parallel.threadCount = 3;
+	parallel.chunkSort = SortAlgorithm::RadixSort;
+	parallel.mergeThreads = 2;
+	ok = sortsWithinBudget(parallel, 16 * 1024 * 1024);
+	std::cout << (ok ? "YES" : "NO") << " 3 radix sort threads and a 2-way parallel merge stay within 16 MB\n";
+
+	SortOptions replacement;
+	replacement.runGeneration = RunGeneration::ReplacementSelection;
+	replacement.inputMode = InputMode::Mapped;
+	ok = sortsWithinBudget(replacement, 8 * 1024 * 1024);
+	std::cout << (ok ? "YES" : "NO") << " Replacement selection stays within 8 MB\n";
+
+	SortOptions adaptive;
+	adaptive.chunkSort = SortAlgorithm::IntroSort;
+	ok = sortsWithinBudget(adaptive, 8 * 1024 * 1024, true);
+	std::cout << (ok ? "YES" : "NO") << " Merging a long natural run with a short tail stays within 8 MB\n";
+
+	std::cout << "\n******************************************\n\n";
+}
+
+int main() {
+	std::cout << "******************************************\n";
+	std::cout << "*       MEMORY GOVERNOR TEST SUITE       *\n";
+	std::cout << "******************************************\n\n";
+
+	testAccounting();
+	testBudgetedSort();
+
+	std::cout << "******************************************\n";
+	std::cout << "*            ALL TESTS COMPLETE          *\n";
+	std::cout << "******************************************\n";
+	return 0;
+}
@@ -2,9 +2,17 @@
 #include <fstream>
 #include <vector>
 #include <algorithm>
+#include <iterator>
 #include "merger.h"
 #include "chunker.h"
+#include "run_format.h"
+#include "loser_tree.h"
+#include "block_pool.h"
+#include "merge_plan.h"
+#include "merge_partition.h"
+#include "file_io.h"
 #include "utils.h"
+#include <climits>
 
 //Sorted chunk fils for testing
 std::vector<std::string> generateTestChunks(int numChunks, int elementsPerChunk) {
@@ -12,14 +20,14 @@ std::vector<std::string> generateTestChunks(int numChunks, int elementsPerChunk)
 	std::vector<std::string> chunkFiles;
 
 	for (int i = 0; i < numChunks; i++) {
-		std::string filename = "test_merge_chunk_" + std::to_string(i) + ".txt";
-		std::ofstream out(filename);
+		std::string filename = "test_merge_chunk_" + std::to_string(i) + ".run";
+		RunWriter out(filename);
 
 		//Generate sorted integers for this chunk
 		int start = i * elementsPerChunk;
 		for (int j = 0; j < elementsPerChunk; j++) {
 			int value = i + j + numChunks;
-			out << value << "\n";
+			out.write(value);
 		}
 		out.close();
 		chunkFiles.push_back(filename);
@@ -227,6 +235,294 @@ void testEdgeCases() {
     std::cout << "******************************************\n\n";
 }
 
+// Test 5: Loser tree with empty runs, duplicates and extreme keys
+void testLoserTree() {
+    std::cout << "***Test 5: Loser Tree***\n\n";
+
+    std::vector<std::vector<int>> runs = {
+        { INT_MIN, -5, 0, 0, 7 },
+        { },
+        { -5, -5, INT_MAX },
+        { 3 },
+        { },
+        { INT_MIN, INT_MAX, INT_MAX }
+    };
+
+    LoserTree tree(runs.size());
+    std::vector<size_t> pos(runs.size(), 0);
+    std::vector<int> expected;
+    for (size_t i = 0; i < runs.size(); i++) {
+        if (!runs[i].empty()) tree.setSource(static_cast<int>(i), runs[i][0]);
+        expected.insert(expected.end(), runs[i].begin(), runs[i].end());
+    }
+    tree.build();
+    std::sort(expected.begin(), expected.end());
+
+    std::vector<int> merged;
+    while (!tree.isEmpty()) {
+        int run = tree.winner();
+        merged.push_back(tree.winnerKey());
+        if (++pos[run] < runs[run].size()) {
+            tree.replaceWinner(runs[run][pos[run]]);
+        }
+        else {
+            tree.exhaustWinner();
+        }
+    }
+    std::cout << (merged == expected ? "YES" : "NO") << " Merged " << merged.size()
+        << " keys from 6 runs (2 empty)\n";
+
+    LoserTree empty(3);
+    empty.build();
+    std::cout << (empty.isEmpty() ? "YES" : "NO") << " All-empty runs finish immediately\n";
+
+    std::cout << "\n******************************************\n\n";
+}
+
+// Test 6: Pooled read blocks sized from run count and budget
+void testBlockPool() {
+    std::cout << "***Test 6: Merge Read Blocks***\n\n";
+
+    size_t few = BlockPool::chooseBlockSize(4, 1, 64 * 1024 * 1024);
+    size_t many = BlockPool::chooseBlockSize(1024, 1, 64 * 1024 * 1024);
+    size_t tooMany = BlockPool::chooseBlockSize(100000, 1, 64 * 1024 * 1024);
+    std::cout << (few == BlockPool::MAX_BLOCK_BYTES ? "YES" : "NO") << " 4 runs: " << formatSize(few) << " blocks\n";
+    std::cout << (many == 64 * 1024 ? "YES" : "NO") << " 1024 runs: " << formatSize(many) << " blocks\n";
+    std::cout << (tooMany == BlockPool::MIN_BLOCK_BYTES ? "YES" : "NO") << " 100000 runs: " << formatSize(tooMany) << " blocks\n";
+
+    // Smallest blocks force many refills per run
+    auto chunks = generateTestChunks(10, 5000);
+    SortOptions options;
+    options.mergeBlockSize = BlockPool::MIN_BLOCK_BYTES;
+
+    Merger merger(chunks, "test_block_merge.txt", options);
+    merger.merge();
+
+    bool correct = verifyOutputSorted("test_block_merge.txt", 50000);
+    std::cout << (correct ? "YES" : "NO") << " Merge through " << formatSize(merger.getBlockSize()) << " blocks\n";
+
+    cleanupTestFiles(chunks);
+    std::remove("test_block_merge.txt");
+
+    std::cout << "\n******************************************\n\n";
+}
+
+// Test 7: Forecasting read-ahead matches synchronous reads, and read
+// errors on the I/O thread reach the merge
+void testReadAhead() {
+    std::cout << "***Test 7: Merge Read-Ahead***\n\n";
+
+    auto chunks = generateTestChunks(16, 3000);
+    for (int readAhead = 0; readAhead < 2; readAhead++) {
+        SortOptions options;
+        options.mergeBlockSize = BlockPool::MIN_BLOCK_BYTES;
+        options.mergeReadAhead = readAhead == 1;
+
+        Merger merger(chunks, "test_read_ahead.txt", options);
+        merger.merge();
+
+        bool correct = verifyOutputSorted("test_read_ahead.txt", 48000);
+        std::cout << (correct ? "YES" : "NO") << (readAhead ? " With" : " Without")
+            << " read-ahead (stalled " << merger.getStallSeconds() << "s)\n";
+        std::remove("test_read_ahead.txt");
+    }
+
+    // Chop the last run so its final block cannot be read
+    {
+        std::ifstream in(chunks.back(), std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+        std::ofstream out(chunks.back(), std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), bytes.size() - 100);
+    }
+
+    bool reported = false;
+    try {
+        Merger merger(chunks, "test_read_ahead.txt");
+        merger.merge();
+    }
+    catch (const std::exception& e) {
+        reported = std::string(e.what()).find("Truncated") != std::string::npos;
+    }
+    std::cout << (reported ? "YES" : "NO") << " Truncated run reported through read-ahead\n";
+
+    cleanupTestFiles(chunks);
+    std::remove("test_read_ahead.txt");
+
+    std::cout << "\n******************************************\n\n";
+}
+
+// Test 8: Cascaded merge with bounded fan-in
+void testCascadedMerge() {
+    std::cout << "***Test 8: Cascaded Merge (fan-in 4)***\n\n";
+
+    // Plan: every run is consumed once and all merges but the first are full
+    std::vector<uint64_t> sizes;
+    for (int i = 0; i < 30; i++) sizes.push_back(1000 + (i * 37) % 500);
+    MergePlan plan = planMerge(sizes, 4);
+
+    std::vector<int> consumed(sizes.size() + plan.steps.size(), 0);
+    bool fullMerges = true;
+    for (size_t s = 0; s < plan.steps.size(); s++) {
+        for (size_t id : plan.steps[s].inputs) consumed[id]++;
+        if (s > 0 && plan.steps[s].inputs.size() != 4) fullMerges = false;
+    }
+    bool consumedOnce = std::count(consumed.begin(), consumed.end() - 1, 1)
+        == static_cast<long>(consumed.size() - 1) && consumed.back() == 0;
+    std::cout << (consumedOnce && fullMerges ? "YES" : "NO") << " Plan: " << plan.steps.size()
+        << " merges, depth " << plan.depth << ", first merge of " << plan.steps[0].inputs.size() << " runs\n";
+
+    // Smallest runs go first
+    std::vector<uint64_t> sorted = sizes;
+    std::sort(sorted.begin(), sorted.end());
+    uint64_t smallest = 0;
+    for (size_t i = 0; i < plan.steps[0].inputs.size(); i++) smallest += sorted[i];
+    bool smallestFirst = plan.steps[0].elements == smallest;
+    std::cout << (smallestFirst ? "YES" : "NO") << " First merge takes the smallest runs\n";
+
+    // Merge: same output as a single pass, no intermediate files left
+    auto chunks = generateTestChunks(30, 200);
+    SortOptions options;
+    options.maxFanIn = 4;
+
+    Merger merger(chunks, "test_cascade.txt", options);
+    merger.merge();
+
+    bool correct = verifyOutputSorted("test_cascade.txt", 6000);
+    bool leftovers = false;
+    for (size_t id = 0; id < 64; id++) {
+        leftovers = leftovers || FileIO::exists("temp_merge_" + std::to_string(id) + ".run");
+    }
+    std::cout << (correct && !leftovers ? "YES" : "NO") << " " << merger.getPlan().depth
+        << " passes, " << formatSize(merger.getBytesRewritten()) << " rewritten, intermediates deleted\n";
+
+    cleanupTestFiles(chunks);
+    std::remove("test_cascade.txt");
+
+    std::cout << "\n******************************************\n\n";
+}
+
+// Test 9: Parallel merge over key ranges
+void testParallelMerge() {
+    std::cout << "***Test 9: Parallel Merge (4 key ranges)***\n\n";
+
+    auto chunks = generateTestChunks(8, 150000);
+
+    // Slices: every value of every run lands in exactly one part, in order
+    auto slices = partitionRuns(chunks, 4);
+    bool covered = slices.size() == 4;
+    for (size_t r = 0; r < chunks.size() && covered; r++) {
+        uint64_t next = 0;
+        for (size_t p = 0; p < slices.size(); p++) {
+            covered = covered && slices[p][r].start == next;
+            next += slices[p][r].count;
+        }
+        covered = covered && next == 150000;
+    }
+    std::cout << (covered ? "YES" : "NO") << " Slices cover every run without gaps\n";
+
+    // Same bytes as the single-threaded merge
+    Merger sequential(chunks, "test_merge_sequential.txt");
+    sequential.merge();
+
+    SortOptions options;
+    options.mergeThreads = 4;
+    Merger parallel(chunks, "test_merge_parallel.txt", options);
+    parallel.merge();
+
+    std::ifstream a("test_merge_sequential.txt", std::ios::binary);
+    std::ifstream b("test_merge_parallel.txt", std::ios::binary);
+    std::string first((std::istreambuf_iterator<char>(a)), std::istreambuf_iterator<char>());
+    std::string second((std::istreambuf_iterator<char>(b)), std::istreambuf_iterator<char>());
+    a.close();
+    b.close();
+    bool leftovers = FileIO::exists("temp_segment_1.txt") || FileIO::exists("temp_segment_3.txt");
+    std::cout << (!first.empty() && first == second && !leftovers ? "YES" : "NO")
+        << " Output byte-identical to the sequential merge (" << second.size() << " bytes)\n";
+
+    cleanupTestFiles(chunks);
+    std::remove("test_merge_sequential.txt");
+    std::remove("test_merge_parallel.txt");
+
+    std::cout << "\n******************************************\n\n";
+}
+
+// Test 10: Delta + bit-packed runs
+void testPackedRuns() {
+    std::cout << "***Test 10: Packed Runs***\n\n";
+
+    // Round trip through frame edges, 0- and 32-bit differences and
+    // unsorted data, read back through a buffer smaller than a frame
+    std::vector<std::vector<int>> cases;
+    std::vector<int> wide = { INT_MIN, -5, 0, 7, INT_MAX };
+    cases.push_back(wide);
+    cases.push_back(std::vector<int>(2000, 42));
+    for (size_t n : { (size_t)1, (size_t)3, RUN_FRAME_VALUES - 1, RUN_FRAME_VALUES, RUN_FRAME_VALUES + 5, (size_t)100000 }) {
+        std::vector<int> values(n);
+        for (size_t i = 0; i < n; i++) values[i] = rand() - RAND_MAX / 2;
+        if (n != 100000) std::sort(values.begin(), values.end());
+        cases.push_back(values);
+    }
+    bool roundTrip = true;
+    for (const auto& values : cases) {
+        RunWriter out("test_packed.run", 3000, true);
+        out.write(values.data(), values.size());
+        out.close();
+
+        RunReader in("test_packed.run", 7);
+        std::vector<int> back(values.size() + 1);
+        roundTrip = roundTrip && isPackedRun(in.getHeader()) && in.read(back.data(), back.size()) == values.size()
+            && std::equal(values.begin(), values.end(), back.begin());
+    }
+    std::remove("test_packed.run");
+    std::cout << (roundTrip ? "YES" : "NO") << " " << cases.size() << " runs decode to the values written\n";
+
+    // Raw and packed copies of the same runs merge to the same bytes,
+    // sequentially and over key ranges (which seek inside packed frames)
+    std::vector<std::string> raw, packed;
+    uint64_t rawBytes = 0, packedBytes = 0;
+    for (int r = 0; r < 6; r++) {
+        std::vector<int> values(120000 + r * 1000);
+        for (size_t i = 0; i < values.size(); i++) values[i] = rand() % 5000000;
+        std::sort(values.begin(), values.end());
+        raw.push_back("test_raw_" + std::to_string(r) + ".run");
+        packed.push_back("test_packed_" + std::to_string(r) + ".run");
+        RunWriter a(raw.back());
+        a.write(values.data(), values.size());
+        a.close();
+        RunWriter b(packed.back(), 64 * 1024, true);
+        b.write(values.data(), values.size());
+        b.close();
+        rawBytes += a.getBytesWritten();
+        packedBytes += b.getBytesWritten();
+    }
+
+    Merger fromRaw(raw, "test_merge_raw.txt");
+    fromRaw.merge();
+    SortOptions options;
+    options.mergeThreads = 3;
+    Merger fromPacked(packed, "test_merge_packed.txt", options);
+    fromPacked.merge();
+
+    std::ifstream a("test_merge_raw.txt", std::ios::binary);
+    std::ifstream b("test_merge_packed.txt", std::ios::binary);
+    std::string first((std::istreambuf_iterator<char>(a)), std::istreambuf_iterator<char>());
+    std::string second((std::istreambuf_iterator<char>(b)), std::istreambuf_iterator<char>());
+    a.close();
+    b.close();
+    std::cout << (!first.empty() && first == second ? "YES" : "NO")
+        << " Packed runs merge (3 key ranges) to the raw runs' output\n";
+    std::cout << (packedBytes * 3 < rawBytes ? "YES" : "NO") << " Packed runs: " << formatSize(packedBytes)
+        << " instead of " << formatSize(rawBytes) << "\n";
+
+    cleanupTestFiles(raw);
+    cleanupTestFiles(packed);
+    std::remove("test_merge_raw.txt");
+    std::remove("test_merge_packed.txt");
+
+    std::cout << "\n******************************************\n\n";
+}
+
 int main() {
     std::cout << "******************************************\n";
     std::cout << "*            MERGER TEST SUITE           *\n";
@@ -236,6 +532,12 @@ int main() {
     testMediumMerge();
     testIntegration();
     testEdgeCases();
+    testLoserTree();
+    testBlockPool();
+    testReadAhead();
+    testCascadedMerge();
+    testParallelMerge();
+    testPackedRuns();
 
     std::cout << "******************************************\n";
     std::cout << "*            ALL TESTS COMPLETE          *\n";
@@ -0,0 +1,254 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <climits>
+#include "int_parser.h"
+#include "int_writer.h"
+#include "file_io.h"
+#include "mapped_input.h"
+
+// Write raw text to a file
+void writeText(const std::string& filename, const std::string& text) {
+	std::ofstream out(filename, std::ios::binary);
+	out << text;
+	out.close();
+}
+
+// Parse a whole file with the given block size
+std::vector<int> parseAll(const std::string& filename, size_t blockSize) {
+	IntParser parser(filename, blockSize);
+	std::vector<int> values;
+	int value;
+	while (parser.next(value)) {
+		values.push_back(value);
+	}
+	return values;
+}
+
+// Test 1: values must match istream >> for every block size
+void testMatchesIstream() {
+	std::cout << "***Test 1: Parser matches istream (all block sizes)***\n\n";
+
+	std::vector<int> expected;
+	std::string text;
+	for (int i = 0; i < 5000; i++) {
+		int value = (rand() % 2000001) - 1000000;
+		expected.push_back(value);
+		text += std::to_string(value) + (i % 7 == 0 ? "\r\n" : "\n");
+	}
+	expected.push_back(INT_MIN);
+	expected.push_back(INT_MAX);
+	text += "  -2147483648\t+2147483647";   // No trailing newline
+	writeText("test_parser_input.txt", text);
+
+	bool allMatch = true;
+	size_t blockSizes[] = { 1, 2, 3, 7, 16, 31, 64, 4096, 1024 * 1024 };
+	for (size_t blockSize : blockSizes) {
+		bool match = parseAll("test_parser_input.txt", blockSize) == expected;
+		std::cout << "  Block size " << blockSize << ": " << (match ? "OK" : "MISMATCH") << "\n";
+		allMatch = allMatch && match;
+	}
+
+	std::cout << (allMatch ? " TEST 1 PASSED\n" : " TEST 1 FAILED\n");
+	std::remove("test_parser_input.txt");
+	std::cout << "\n*****************************************\n\n";
+}
+
+// Test 2: fill() stops at maxCount and never reallocates
+void testFillReusesBuffer() {
+	std::cout << "***Test 2: fill() reuses the chunk buffer***\n\n";
+
+	std::string text;
+	for (int i = 0; i < 1000; i++) {
+		text += std::to_string(i) + "\n";
+	}
+	writeText("test_parser_fill.txt", text);
+
+	IntParser parser("test_parser_fill.txt", 64);
+	std::vector<int> chunk;
+	chunk.reserve(300);
+	const int* data = chunk.data();
+
+	bool correct = true;
+	int expectedNext = 0;
+	size_t chunks = 0;
+	while (parser.fill(chunk, 300) > 0) {
+		correct = correct && chunk.size() <= 300 && chunk.data() == data;
+		for (int value : chunk) {
+			correct = correct && value == expectedNext++;
+		}
+		chunk.clear();
+		chunks++;
+	}
+
+	std::cout << "  Chunks: " << chunks << " (expected: 4)\n";
+	correct = correct && chunks == 4 && expectedNext == 1000;
+	std::cout << (correct ? " TEST 2 PASSED\n" : " TEST 2 FAILED\n");
+	std::remove("test_parser_fill.txt");
+	std::cout << "\n*****************************************\n\n";
+}
+
+// Test 3: malformed input is reported with its byte offset
+void testMalformed() {
+	std::cout << "***Test 3: Malformed input***\n\n";
+
+	struct Case {
+		const char* text;
+		uint64_t offset;
+		uint64_t line;
+	};
+	Case cases[] = {
+		{ "1\n2\nabc\n", 4, 3 },
+		{ "10\n12x\n", 3, 2 },
+		{ "5\n2147483648\n", 2, 2 },
+		{ "-\n", 0, 1 },
+		{ "1 2 3 99999999999999999999\n", 6, 1 },
+		{ "5\n0000000000000000002147483648\n", 2, 2 },
+	};
+
+	bool allPassed = true;
+	for (const Case& c : cases) {
+		writeText("test_parser_bad.txt", c.text);
+		size_t blockSizes[] = { 3, 4096 };
+		for (size_t blockSize : blockSizes) {
+			bool caught = false;
+			try {
+				parseAll("test_parser_bad.txt", blockSize);
+			}
+			catch (const ParseError& e) {
+				caught = e.getOffset() == c.offset && e.getLine() == c.line;
+				if (blockSize == 4096) std::cout << "  " << e.what() << "\n";
+			}
+			allPassed = allPassed && caught;
+		}
+	}
+
+	//Zero padding is valid, however long (istream >> accepts it too),
+	//also when the token runs across a block boundary: 40-byte blocks
+	//end inside the 46- and 71-character tokens
+	std::string padded = "0000000000000000042\n-00000000000000000002147483648\n000\n"
+		+ std::string(45, '0') + "7\n" + std::string(70, '0') + "9\n";
+	writeText("test_parser_bad.txt", padded);
+	size_t paddedBlockSizes[] = { 3, 40, 4096 };
+	for (size_t blockSize : paddedBlockSizes) {
+		std::vector<int> values = parseAll("test_parser_bad.txt", blockSize);
+		allPassed = allPassed && values == std::vector<int>({ 42, INT_MIN, 0, 7, 9 });
+	}
+
+	std::cout << (allPassed ? " TEST 3 PASSED\n" : " TEST 3 FAILED\n");
+	std::remove("test_parser_bad.txt");
+	std::cout << "\n*****************************************\n\n";
+}
+
+// Test 4: IntWriter output parses back to the same values
+void testWriterRoundTrip() {
+	std::cout << "***Test 4: IntWriter round trip***\n\n";
+
+	std::vector<int> values = { 0, 1, -1, 9, 10, 99, 100, -100, 12345, -98765,
+		1000000, -1000000, INT_MAX, INT_MIN, INT_MAX - 1, INT_MIN + 1 };
+	for (int i = 0; i < 10000; i++) {
+		values.push_back(rand() - RAND_MAX / 2);
+	}
+
+	// Tiny buffer forces many flushes
+	IntWriter writer("test_writer_output.txt", 16);
+	writer.write(values.data(), values.size() / 2);
+	for (size_t i = values.size() / 2; i < values.size(); i++) {
+		writer.write(values[i]);
+	}
+	writer.close();
+
+	bool correct = parseAll("test_writer_output.txt", 4096) == values;
+	std::cout << (correct ? " TEST 4 PASSED\n" : " TEST 4 FAILED\n");
+	std::remove("test_writer_output.txt");
+	std::cout << "\n*****************************************\n\n";
+}
+
+// Test 5: mmap windows give the same values as buffered reads
+void testMappedSource() {
+	std::cout << "***Test 5: Memory-mapped input***\n\n";
+
+	std::string text;
+	for (int i = 0; i < 20000; i++) {
+		text += std::to_string(rand() - RAND_MAX / 2) + "\n";
+	}
+	writeText("test_parser_mapped.txt", text);
+
+	// Smallest window (one page) so tokens straddle many window edges
+	std::unique_ptr<BlockSource> source(new MappedBlockSource("test_parser_mapped.txt", 1));
+	IntParser mapped(std::move(source), "test_parser_mapped.txt");
+	std::vector<int> values;
+	int value;
+	while (mapped.next(value)) {
+		values.push_back(value);
+	}
+	bool correct = values == parseAll("test_parser_mapped.txt", 4096);
+	std::cout << "  " << values.size() << " values through "
+		<< MappedBlockSource::pageSize() << "-byte windows\n";
+
+	writeText("test_parser_mapped.txt", "");
+	IntParser empty(std::unique_ptr<BlockSource>(new MappedBlockSource("test_parser_mapped.txt")), "empty");
+	correct = correct && !empty.next(value);
+
+	std::cout << (correct ? " TEST 5 PASSED\n" : " TEST 5 FAILED\n");
+	std::remove("test_parser_mapped.txt");
+	std::cout << "\n*****************************************\n\n";
+}
+
+void testAsyncWriter() {
+	std::cout << "***Test 6: AsyncIntWriter***\n\n";
+
+	std::vector<int> values;
+	for (int i = 0; i < 100000; i++) {
+		values.push_back(rand() - RAND_MAX / 2);
+	}
+
+	// Small buffers: the merge side swaps many times
+	AsyncIntWriter writer("test_async_output.txt", true, 1000, 3);
+	for (int value : values) {
+		writer.write(value);
+	}
+	writer.close();
+
+	bool correct = parseAll("test_async_output.txt", 4096) == values
+		&& writer.getBytesWritten() == FileIO::getFileSize("test_async_output.txt");
+	std::remove("test_async_output.txt");
+
+#ifndef _WIN32
+	// Write errors on the writer thread surface in close()
+	bool reported = false;
+	try {
+		AsyncIntWriter full("/dev/full", false, 1000, 2);
+		for (int value : values) {
+			full.write(value);
+		}
+		full.close();
+	}
+	catch (const std::runtime_error&) {
+		reported = true;
+	}
+	correct = correct && reported;
+#endif
+
+	std::cout << (correct ? " TEST 6 PASSED\n" : " TEST 6 FAILED\n");
+	std::cout << "\n*****************************************\n\n";
+}
+
+int main() {
+	std::cout << "******************************************\n";
+	std::cout << "*            PARSER TEST SUITE           *\n";
+	std::cout << "******************************************\n\n";
+
+	testMatchesIstream();
+	testFillReusesBuffer();
+	testMalformed();
+	testWriterRoundTrip();
+	testMappedSource();
+	testAsyncWriter();
+
+	std::cout << "******************************************\n";
+	std::cout << "*            ALL TESTS COMPLETE          *\n";
+	std::cout << "******************************************\n";
+
+	return 0;
+}
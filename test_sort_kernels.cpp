@@ -0,0 +1,178 @@
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <climits>
+#include <string>
+#include "sort_strategy.h"
+#include "natural_runs.h"
+
+// Input patterns that stress quicksort pivots and radix digits
+std::vector<int> makePattern(const std::string& pattern, size_t n) {
+	std::vector<int> v(n);
+	for (size_t i = 0; i < n; i++) {
+		int x = static_cast<int>(i);
+		if (pattern == "random") v[i] = rand() - RAND_MAX / 2;
+		else if (pattern == "sorted") v[i] = x;
+		else if (pattern == "reverse") v[i] = static_cast<int>(n) - x;
+		else if (pattern == "equal") v[i] = 7;
+		else if (pattern == "few unique") v[i] = rand() % 4;
+		else if (pattern == "organ pipe") v[i] = i < n / 2 ? x : static_cast<int>(n) - x;
+		else if (pattern == "sawtooth") v[i] = x % 1000;
+		else if (pattern == "extremes") v[i] = (rand() % 3 == 0) ? INT_MIN : (rand() % 2 ? INT_MAX : 0);
+		else if (pattern == "nearly sorted") v[i] = (i % 100 == 0) ? rand() : x;
+	}
+	return v;
+}
+
+// Test: every strategy sorts every pattern like std::sort
+void testAllStrategies() {
+	std::cout << "***Test 1: All chunk sort strategies***\n\n";
+
+	SortAlgorithm algorithms[] = { SortAlgorithm::HeapSort, SortAlgorithm::IntroSort,
+		SortAlgorithm::PdqSort, SortAlgorithm::RadixSort, SortAlgorithm::ParallelSampleSort };
+	const char* patterns[] = { "random", "sorted", "reverse", "equal", "few unique",
+		"organ pipe", "sawtooth", "extremes", "nearly sorted" };
+	size_t sizes[] = { 0, 1, 2, 23, 100, 1000, 200000 };
+
+	bool allPassed = true;
+	for (SortAlgorithm algorithm : algorithms) {
+		std::unique_ptr<ChunkSortStrategy> sorter = makeSortStrategy(algorithm, 4);
+		bool passed = sorter->algorithm() == algorithm;
+
+		for (const char* pattern : patterns) {
+			for (size_t n : sizes) {
+				std::vector<int> data = makePattern(pattern, n);
+				std::vector<int> expected = data;
+				std::sort(expected.begin(), expected.end());
+
+				sorter->sort(data);
+				if (data != expected) {
+					std::cout << "  FAILED: " << sortAlgorithmName(algorithm)
+						<< " on " << pattern << " (" << n << ")\n";
+					passed = false;
+				}
+			}
+		}
+
+		std::cout << "  " << sortAlgorithmName(algorithm) << ": " << (passed ? "OK" : "FAILED") << "\n";
+		allPassed = allPassed && passed;
+	}
+
+	std::cout << (allPassed ? " TEST 1 PASSED\n" : " TEST 1 FAILED\n");
+	std::cout << "\n*****************************************\n\n";
+}
+
+// Test: command-line names round trip
+void testParseNames() {
+	std::cout << "***Test 2: Strategy names***\n\n";
+
+	const char* names[] = { "heap", "intro", "pdq", "radix", "sample" };
+	bool passed = true;
+	for (const char* name : names) {
+		SortAlgorithm algorithm;
+		passed = passed && parseSortAlgorithm(name, algorithm);
+		std::cout << "  " << name << " -> " << sortAlgorithmName(algorithm) << "\n";
+	}
+	SortAlgorithm unused;
+	passed = passed && !parseSortAlgorithm("bogus", unused);
+
+	std::cout << (passed ? " TEST 2 PASSED\n" : " TEST 2 FAILED\n");
+	std::cout << "\n*****************************************\n\n";
+}
+
+// Test: natural run detection sorts what it claims and leaves the rest
+void testNaturalRuns() {
+	std::cout << "***Test 3: Natural runs***\n\n";
+
+	struct Case {
+		const char* pattern;
+		NaturalOrder expected;
+	};
+	Case cases[] = {
+		{ "sorted", NaturalOrder::Ascending },
+		{ "reverse", NaturalOrder::Descending },
+		{ "equal", NaturalOrder::Ascending },
+		{ "organ pipe", NaturalOrder::Runs },
+		{ "sawtooth", NaturalOrder::Runs },
+		{ "random", NaturalOrder::Unsorted },
+		{ "nearly sorted", NaturalOrder::Unsorted },
+	};
+
+	bool passed = true;
+	for (const Case& c : cases) {
+		std::vector<int> data = makePattern(c.pattern, 200000);
+		std::vector<int> expected = data;
+		std::sort(expected.begin(), expected.end());
+		std::vector<int> original = data;
+		std::sort(original.begin(), original.end());
+
+		std::vector<int> scratch;
+		size_t runs;
+		NaturalOrder order = NaturalRunSort::sort(data, scratch, runs);
+
+		//Unsorted chunks may be partly reordered, but keep their values
+		bool ok = order == c.expected;
+		if (order == NaturalOrder::Unsorted) {
+			std::sort(data.begin(), data.end());
+		}
+		ok = ok && data == expected;
+		std::cout << "  " << c.pattern << ": " << runs << " runs, " << (ok ? "OK" : "FAILED") << "\n";
+		passed = passed && ok;
+	}
+
+	//Many random runs of 1000 (Timsort stack with uneven lengths)
+	std::vector<int> data;
+	for (int r = 0; r < 150; r++) {
+		std::vector<int> run(500 + rand() % 1000);
+		for (int& x : run) x = rand() % 100000;
+		std::sort(run.begin(), run.end());
+		if (r % 3 == 0) std::reverse(run.begin(), run.end());
+		data.insert(data.end(), run.begin(), run.end());
+	}
+	std::vector<int> expected = data;
+	std::sort(expected.begin(), expected.end());
+	std::vector<int> scratch;
+	size_t runs;
+	bool merged = NaturalRunSort::sort(data, scratch, runs) == NaturalOrder::Runs && data == expected;
+	std::cout << "  150 mixed runs: " << runs << " runs, " << (merged ? "OK" : "FAILED") << "\n";
+	passed = passed && merged;
+
+	//One long run plus a short unsorted tail, and the mirror image: only
+	//the shorter run is copied out, so scratch stays within half the chunk
+	for (int longFirst = 0; longFirst < 2; longFirst++) {
+		std::vector<int> longRun = makePattern("sorted", 1000000);
+		std::vector<int> tail(3000);
+		for (int& x : tail) x = rand() % 2000000;
+		std::sort(tail.begin(), tail.end());
+		std::reverse(tail.begin() + 1000, tail.end());
+		data = longFirst ? longRun : tail;
+		data.insert(data.end(), longFirst ? tail.begin() : longRun.begin(), longFirst ? tail.end() : longRun.end());
+		expected = data;
+		std::sort(expected.begin(), expected.end());
+		scratch = std::vector<int>();
+		bool ok = NaturalRunSort::sort(data, scratch, runs) == NaturalOrder::Runs && data == expected &&
+			scratch.capacity() <= data.size() / 2 + 1;
+		std::cout << "  " << (longFirst ? "long run + tail" : "head + long run") << ": scratch " << scratch.capacity()
+			<< " of " << data.size() << ", " << (ok ? "OK" : "FAILED") << "\n";
+		passed = passed && ok;
+	}
+
+	std::cout << (passed ? " TEST 3 PASSED\n" : " TEST 3 FAILED\n");
+	std::cout << "\n*****************************************\n\n";
+}
+
+int main() {
+	std::cout << "******************************************\n";
+	std::cout << "*         SORT KERNEL TEST SUITE         *\n";
+	std::cout << "******************************************\n\n";
+
+	testAllStrategies();
+	testParseNames();
+	testNaturalRuns();
+
+	std::cout << "******************************************\n";
+	std::cout << "*            ALL TESTS COMPLETE          *\n";
+	std::cout << "******************************************\n";
+
+	return 0;
+}
@@ -0,0 +1,107 @@
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include "sort_planner.h"
+
+//Sample of one window holding the given values
+InputSample makeSample(const std::vector<int>& values) {
+	InputSample sample;
+	sample.values = values;
+	sample.windowStarts.push_back(0);
+	sample.fileBytes = values.size() * 8;
+	sample.sampledBytes = values.size() * 8;
+	return sample;
+}
+
+void testProfiles() {
+	std::cout << "***Test 1: Input Profiles***\n\n";
+
+	std::vector<int> ascending(10000), duplicates(10000), random(10000);
+	for (int i = 0; i < 10000; i++) {
+		ascending[i] = i * 3;
+		duplicates[i] = rand() % 10;
+		random[i] = rand();
+	}
+	InputProfile sorted = profileInput(makeSample(ascending));
+	InputProfile dup = profileInput(makeSample(duplicates));
+	InputProfile rnd = profileInput(makeSample(random));
+
+	bool ok = sorted.ascendingRatio == 1.0 && sorted.descendingRatio == 0.0 && sorted.duplicateRatio == 0.0
+		&& dup.duplicateRatio > 0.99 && rnd.ascendingRatio > 0.4 && rnd.ascendingRatio < 0.6
+		&& sorted.estimatedCount == 10000 && sorted.maxValue == 29997;
+	std::cout << (ok ? "YES" : "NO") << " Sortedness, duplicates, range and count estimated\n";
+
+	//Window edges are not neighbours: two descending windows stay descending
+	InputSample windows = makeSample({ 5, 4, 3, 9, 8, 7 });
+	windows.windowStarts.push_back(3);
+	InputProfile edges = profileInput(windows);
+	std::cout << (edges.descendingRatio == 1.0 ? "YES" : "NO") << " Pairs taken within each window\n";
+
+	std::cout << "\n******************************************\n\n";
+}
+
+void testPlans() {
+	std::cout << "***Test 2: Plans***\n\n";
+
+	SortOptions options;
+	options.countingSort = false;
+	InputProfile profile;
+	profile.sampleSize = 10000;
+	profile.estimatedCount = 50000000;
+	profile.minValue = INT32_MIN;
+	profile.maxValue = INT32_MAX;
+
+	profile.ascendingRatio = 0.5;
+	SortPlan random = planSort(profile, options);
+	std::cout << (random.kernel == SortAlgorithm::RadixSort && random.runGeneration == RunGeneration::FixedChunks
+		? "YES" : "NO") << " Random keys: radix sort, " << random.chunkSize / (1024 * 1024) << " MB chunks\n";
+
+	profile.ascendingRatio = 0.995;
+	SortPlan sorted = planSort(profile, options);
+	std::cout << (sorted.kernel == SortAlgorithm::PdqSort && sorted.runGeneration == RunGeneration::FixedChunks
+		? "YES" : "NO") << " Nearly sorted: fixed chunks for natural runs\n";
+
+	profile.ascendingRatio = 0.8;
+	SortPlan partly = planSort(profile, options);
+	std::cout << (partly.runGeneration == RunGeneration::ReplacementSelection ? "YES" : "NO")
+		<< " Partly sorted: replacement selection\n";
+
+	profile.ascendingRatio = 0.5;
+	profile.duplicateRatio = 0.9;
+	SortPlan dup = planSort(profile, options);
+	std::cout << (dup.kernel == SortAlgorithm::PdqSort ? "YES" : "NO") << " Duplicates: pdq sort\n";
+
+	//Tiny chunks and a huge input: more runs than one pass can take
+	profile.duplicateRatio = 0;
+	profile.estimatedCount = 1000000000;
+	options.chunkMemoryBudget = 2 * 1024 * 1024;
+	SortPlan many = planSort(profile, options);
+	bool balanced = many.expectedPasses == 2 && many.fanIn > 0
+		&& many.fanIn * many.fanIn >= many.expectedRuns && (many.fanIn - 1) * (many.fanIn - 1) < many.expectedRuns;
+	std::cout << (balanced ? "YES" : "NO") << " " << many.expectedRuns << " runs: fan-in " << many.fanIn
+		<< " in " << many.expectedPasses << " balanced passes\n";
+
+	//Small input: one chunk that fits it
+	profile.estimatedCount = 1000;
+	options.chunkMemoryBudget = 0;
+	SortPlan small = planSort(profile, options);
+	std::cout << (small.chunkSize == 1024 * 1024 && small.expectedRuns == 1 ? "YES" : "NO")
+		<< " Small input: a single 1 MB chunk\n";
+
+	std::cout << "\n******************************************\n\n";
+}
+
+int main() {
+	std::cout << "******************************************\n";
+	std::cout << "*        SORT PLANNER TEST SUITE         *\n";
+	std::cout << "******************************************\n\n";
+
+	testProfiles();
+	testPlans();
+
+	std::cout << "******************************************\n";
+	std::cout << "*            ALL TESTS COMPLETE          *\n";
+	std::cout << "******************************************\n";
+	return 0;
+}
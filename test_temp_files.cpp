@@ -0,0 +1,134 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdio>
+#include "temp_files.h"
+#include "chunker.h"
+#include "merger.h"
+#include "file_io.h"
+
+//Directory part of a temp file path
+std::string directoryOf(const std::string& path) {
+	return path.substr(0, path.find_last_of('/'));
+}
+
+void testPlacement() {
+	std::cout << "***Test 1: Temp File Placement***\n\n";
+
+	FileIO::makeDirectory("test_tmp_a");
+	FileIO::makeDirectory("test_tmp_b");
+	std::vector<std::string> roots = { "test_tmp_a", "test_tmp_b/" };
+	{
+		TempFiles temp(roots, TempPlacement::RoundRobin);
+		TempFiles other(roots, TempPlacement::RoundRobin);
+		std::vector<std::string> dirs = temp.getDirectories();
+
+		std::string first = temp.path("temp_chunk_0.run");
+		std::string second = temp.path("temp_chunk_1.run");
+		std::string third = temp.path("temp_chunk_2.run");
+		bool alternates = directoryOf(first) == dirs[0] && directoryOf(second) == dirs[1]
+			&& directoryOf(third) == dirs[0];
+		std::cout << (alternates ? "YES" : "NO") << " Round-robin over " << dirs.size() << " directories\n";
+		std::cout << (temp.path("temp_chunk_1.run") == second ? "YES" : "NO") << " A name keeps its path\n";
+		std::cout << (other.path("temp_chunk_0.run") != first && FileIO::exists(dirs[0]) ? "YES" : "NO")
+			<< " Two jobs in the same directories get different paths\n";
+
+		//Left behind by a component: removed with the job
+		std::ofstream(first) << "1\n";
+		TempFiles freeSpace(roots, TempPlacement::FreeSpace);
+		std::string placed = freeSpace.path("temp_merge_0.run");
+		std::vector<std::string> freeDirs = freeSpace.getDirectories();
+		std::cout << (std::find(freeDirs.begin(), freeDirs.end(), directoryOf(placed)) != freeDirs.end() ? "YES" : "NO")
+			<< " Most free space picks one of the job's directories\n";
+	}
+	bool gone = true;
+	for (const std::string& root : { std::string("test_tmp_a"), std::string("test_tmp_b") }) {
+		//rmdir only removes an empty directory, so it can be made again
+		FileIO::removeDirectory(root);
+		gone = gone && FileIO::makeDirectory(root);
+		FileIO::removeDirectory(root);
+	}
+	std::cout << (gone ? "YES" : "NO") << " Job directories and leftover files deleted at the end\n";
+
+	bool threw = false;
+	try {
+		TempFiles missing({ "test_tmp_missing/deeper" }, TempPlacement::RoundRobin);
+	}
+	catch (const std::runtime_error&) {
+		threw = true;
+	}
+	std::cout << (threw ? "YES" : "NO") << " A missing temp directory is reported\n";
+
+	std::cout << "\n******************************************\n\n";
+}
+
+void testSortInTempDirs() {
+	std::cout << "***Test 2: Runs Spread Over Temp Directories***\n\n";
+
+	std::vector<int> values(300000);
+	{
+		std::ofstream out("test_tmp_input.txt");
+		for (size_t i = 0; i < values.size(); i++) {
+			values[i] = rand() - RAND_MAX / 2;
+			out << values[i] << "\n";
+		}
+	}
+
+	FileIO::makeDirectory("test_tmp_a");
+	FileIO::makeDirectory("test_tmp_b");
+	bool spread = true;
+	{
+		TempFiles temp({ "test_tmp_a", "test_tmp_b" }, TempPlacement::RoundRobin);
+		SortOptions options;
+		options.temp = &temp;
+		options.maxFanIn = 2;
+
+		Chunker chunker("test_tmp_input.txt", 256 * 1024, options);
+		std::vector<std::string> runs = chunker.createSortedChunks();
+		for (size_t r = 0; r < runs.size(); r++) {
+			spread = spread && directoryOf(runs[r]) == temp.getDirectories()[r % 2];
+		}
+		Merger merger(runs, "test_tmp_output.txt", options);
+		merger.merge();
+		chunker.cleanupTempFiles();
+		spread = spread && runs.size() > 2;
+	}
+
+	std::vector<int> sorted;
+	{
+		std::ifstream in("test_tmp_output.txt");
+		int v;
+		while (in >> v) sorted.push_back(v);
+	}
+	std::sort(values.begin(), values.end());
+	std::cout << (spread ? "YES" : "NO") << " Runs alternate between the directories\n";
+	std::cout << (sorted == values ? "YES" : "NO") << " Multi-pass merge output matches std::sort\n";
+
+	FileIO::removeDirectory("test_tmp_a");
+	FileIO::removeDirectory("test_tmp_b");
+	bool empty = FileIO::makeDirectory("test_tmp_a") && FileIO::makeDirectory("test_tmp_b");
+	FileIO::removeDirectory("test_tmp_a");
+	FileIO::removeDirectory("test_tmp_b");
+	std::cout << (empty ? "YES" : "NO") << " Nothing left in the temp directories\n";
+
+	std::remove("test_tmp_input.txt");
+	std::remove("test_tmp_output.txt");
+	std::cout << "\n******************************************\n\n";
+}
+
+int main() {
+	std::cout << "******************************************\n";
+	std::cout << "*        TEMP FILES TEST SUITE           *\n";
+	std::cout << "******************************************\n\n";
+
+	testPlacement();
+	testSortInTempDirs();
+
+	std::cout << "******************************************\n";
+	std::cout << "*            ALL TESTS COMPLETE          *\n";
+	std::cout << "******************************************\n";
+	return 0;
+}
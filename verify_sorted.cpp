@@ -1,23 +1,13 @@
 #include <iostream>
-#include <fstream>
 #include <string>
+#include "int_parser.h"
 
-int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cout << "Usage: verify_sorted <filename>\n";
-        return 1;
-    }
-
-    std::string filename = argv[1];
-    std::ifstream in(filename);
-
-    if (!in.is_open()) {
-        std::cerr << "Cannot open file: " << filename << "\n";
-        return 1;
-    }
+int verifyFile(const std::string& filename) {
+    // Throws if the file cannot be opened or holds a malformed line
+    IntParser in(filename);
 
     int prev, curr;
-    if (!(in >> prev)) {
+    if (!in.next(prev)) {
         std::cout << "Empty file\n";
         return 0;
     }
@@ -25,7 +15,7 @@ int main(int argc, char* argv[]) {
     size_t count = 1;
     bool sorted = true;
 
-    while (in >> curr) {
+    while (in.next(curr)) {
         if (curr < prev) {
             std::cout << " NOT SORTED at position " << count << "\n";
             std::cout << "  Previous: " << prev << ", Current: " << curr << "\n";
@@ -45,13 +35,27 @@ int main(int argc, char* argv[]) {
         std::cout << "  Total elements: " << count << "\n";
 
         // Show first and last few
-        in.clear();
-        in.seekg(0);
+        IntParser head(filename);
         std::cout << "\nFirst 5 elements:\n";
-        for (int i = 0; i < 5 && in >> curr; i++) {
+        for (int i = 0; i < 5 && head.next(curr); i++) {
             std::cout << "  " << curr << "\n";
         }
     }
 
     return sorted ? 0 : 1;
-}
\ No newline at end of file
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::cout << "Usage: verify_sorted <filename>\n";
+        return 1;
+    }
+
+    try {
+        return verifyFile(argv[1]);
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+}